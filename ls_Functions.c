@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // For statx
 #include <unistd.h>
 #include <stdio.h>
 #include <dirent.h>
@@ -10,13 +11,32 @@
 #include <pwd.h>
 #include <grp.h>
 #include <time.h>
-#include <locale.h>
 #include <libgen.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/syscall.h>
 #include "ls_Functions.h"
-
-#define MAX_ENTRIES 100
-
-char *dir;    // Specify the parent directory here (or pass it as an argument)
+#include "ls_Uring.h"
+#include "ls_Pool.h"
+#include "ls_Output.h"
+#include "ls_Sort.h"
+#include "ls_Layout.h"
+
+#define INITIAL_ENTRY_CAPACITY 64     // Entries allocated for a new table
+#define INITIAL_NAME_CAPACITY 4096    // Bytes allocated for a new name arena
+#define URING_MIN_ENTRIES 64          // Smallest table worth batching through io_uring
+#define PARALLEL_STAT_MIN_ENTRIES 256 // Smallest table worth stat'ing on several threads
+#define PARALLEL_STAT_MIN_CHUNK 64    // Fewest entries a worker stats at a time
+#define INITIAL_ID_CACHE_CAPACITY 16  // Slots in a new user or group name cache
+#define INITIAL_LINK_CACHE_CAPACITY 64 // Slots in a new symbolic link target cache
+#define TIME_CACHE_SLOTS 64           // Minutes remembered by the time formatting cache
+#define INITIAL_PATH_LIST_CAPACITY 16 // Names allocated for a new path list
+#define INITIAL_SELECTION_CAPACITY 64 // Slots allocated for a new --top/--bottom selection
+#define MIN_INODE_WIDTH 6             // Narrowest inode column
+#define MIN_NLINK_WIDTH 3             // Narrowest hard link count column
+#define MIN_NAME_WIDTH 6              // Narrowest owner and group columns
+#define MIN_SIZE_WIDTH 5              // Narrowest size column
 
 // External flags from ls_Functions.h
 extern uint8_t is_no_option_enabled;           // Flag to indicate no options specified
@@ -29,124 +49,670 @@ extern uint8_t is_ctime_option_enabled;        // Flag to indicate sorting by ch
 extern uint8_t is_no_sort_enabled;             // Flag to disable sorting
 extern uint8_t is_inode_enabled;               // Flag to display inode numbers
 extern uint8_t is_column_output_enabled;       // Flag for column output format
+extern uint8_t is_dont_sync_enabled;           // Flag to let statx return cached attributes
+extern uint8_t is_io_uring_enabled;            // Flag to allow batched metadata loads through io_uring
+extern uint8_t is_collate_enabled;             // Flag to sort names by the LC_COLLATE locale
+extern uint8_t is_radix_sort_enabled;          // Flag to sort names with the radix sort instead of qsort
+extern size_t top_entry_count;                 // Entries kept by --top/--bottom (0 = list everything)
+extern uint8_t is_bottom_enabled;              // Flag to keep the oldest entries instead of the newest
+extern size_t dirent_buffer_size;              // Size of the getdents64 buffer in bytes
+extern size_t output_line_width;               // Width of the line the default listing fills with columns
+
+// Fields every metadata load needs: the file type and permission bits decide the color
+#define COLOR_STATX_MASK (STATX_TYPE | STATX_MODE)
+#define COLOR_DIRECTORY "\033[34m"     // Blue for directories
+#define COLOR_LINK "\033[36m"          // Cyan for symbolic links
+#define COLOR_EXECUTABLE "\033[32m"    // Green for executables
+#define COLOR_RESET "\033[0m"          // Back to the default color
+
+static int is_statx_unsupported = 0;           // Set once statx failed with ENOSYS; fstatat is used from then on (accessed atomically)
+
+// Cached user or group name of one numeric id
+struct id_name {
+    unsigned int id;        // User or group ID
+    char *name;             // Resolved name, or the ID in decimal if it has no name (NULL = free slot)
+    size_t length;          // Length of the name, so column widths need no strlen
+};
+
+// Hash table of resolved user or group names, so NSS is asked once per distinct ID
+struct id_cache {
+    struct id_name *slots;  // Open-addressing slots, a power of two of them
+    size_t capacity;        // Number of slots
+    size_t count;           // Number of slots in use
+    pthread_mutex_t lock;   // Serializes lookups; getpwuid and getgrgid are not thread-safe
+};
+
+static struct id_cache user_name_cache = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+static struct id_cache group_name_cache = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+// Type of one symbolic link target. A relative target means something else in
+// every directory, so it is keyed by the device and inode of the directory
+// holding the link; an absolute target is keyed by its text alone.
+struct link_target {
+    char *target;           // Target as stored in the link (NULL = free slot)
+    dev_t dir_dev;          // Device of the directory holding the link (0 for absolute targets)
+    ino_t dir_ino;          // Inode of the directory holding the link (0 for absolute targets)
+    size_t hash;            // Hash of the whole key
+    mode_t mode;            // Type and permissions of the target (0 if it could not be stat'ed)
+};
+
+// Hash table of link targets already stat'ed, shared by every thread for the whole run
+struct link_target_cache {
+    struct link_target *slots;  // Open-addressing slots, a power of two of them
+    size_t capacity;            // Number of slots
+    size_t count;               // Number of slots in use
+    pthread_mutex_t lock;       // Serializes lookups and inserts (never held while stat'ing)
+};
+
+static struct link_target_cache link_target_cache = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+// Directory whose entries the calling thread is listing, with its identity
+// fetched at most once per listing to key the relative link targets in it
+struct link_directory {
+    int fd;                 // Open directory being listed (-1 = none)
+    uint8_t is_known;       // Set once `dev` and `ino` have been fetched
+    dev_t dev;              // Device of the directory
+    ino_t ino;              // Inode of the directory
+};
+
+static __thread struct link_directory listing_directory = { -1, 0, 0, 0 };
+
+// Formatted modification time of one minute; the format has no seconds,
+// so every timestamp within the same minute formats the same
+struct time_cache_slot {
+    time_t minute;          // Timestamp divided by 60 (rounded down)
+    uint8_t is_used;        // Set once the slot holds a formatted minute
+    char text[64];          // Formatted time
+};
+
+// Each thread keeps its own cache, so formatting needs no locking
+static __thread struct time_cache_slot time_cache[TIME_CACHE_SLOTS];
+
+__thread struct path_list *subdirectory_sink = NULL;
+
+// Work shared by the threads loading one table's metadata
+struct metadata_load {
+    struct ls_entry_table *table;   // Table being loaded
+    unsigned int mask;              // STATX_* fields to request
+};
+
+// Entry kept by the --top/--bottom selection, with its own copy of the name
+struct top_slot {
+    struct ls_entry entry;          // Loaded metadata; its name points at `name`
+    char name[NAME_MAX + 1];        // Name of the entry
+};
+
+// Bounded heap of the best entries seen so far
+struct top_selection {
+    struct top_slot *slots;         // Storage of the kept entries
+    size_t *heap;                   // Slot indices; the root is the kept entry that would be dropped first
+    size_t count;                   // Number of kept entries
+    size_t allocated;               // Number of slots allocated, grown as entries arrive
+    size_t capacity;                // Number of entries to keep
+    int (*compare)(const void *, const void *);    // Listing order of the entries (newest first)
+    int direction;                  // 1 to keep the first entries of the listing order, -1 to keep the last
+};
+
+// Sorted entries being printed in columns
+struct column_listing {
+    int dir_fd;                     // Open directory containing the entries
+    struct ls_entry *entries;       // Entries in listing order
+};
+
+// Record layout returned by the getdents64 system call
+struct linux_dirent64 {
+    uint64_t d_ino;            // Inode number
+    int64_t d_off;             // Offset of the next record
+    unsigned short d_reclen;   // Length of this record
+    unsigned char d_type;      // File type
+    char d_name[];             // NUL-terminated file name
+};
 
 /**
- * @brief Comparison function for qsort to compare files by their change time (ctime).
- * 
- * This function retrieves the ctime (status change time) of two files and 
- * compares them. It returns -1 if the first file's ctime is more recent, 
- * 1 if it is older, and 0 if both files have the same ctime.
+ * @brief Initializes an empty entry table.
  *
- * @param a Pointer to the first file path (const void* for qsort compatibility).
- * @param b Pointer to the second file path (const void* for qsort compatibility).
- * @return int -1 if the first file is more recent, 1 if older, 0 if the same.
+ * Nothing is allocated until the first entry is added. The table has no
+ * directory until the caller stores an open descriptor in `dir_fd`.
+ *
+ * @param table Table to initialize.
  */
-int compare_by_ctime(const void *a, const void *b) {
-    struct stat file_stat1, file_stat2;  // File metadata structures
-    char full_path1[PATH_MAX], full_path2[PATH_MAX];
-    
-    // Construct full path for the first file
-    snprintf(full_path1, sizeof(full_path1), "%s/%s", dir, *(const char **)a);
+void entry_table_init(struct ls_entry_table *table) {
+    memset(table, 0, sizeof(*table));
+    table->dir_fd = -1;
+}
 
-     // Get file stats for the first file
-    if (stat(full_path1, &file_stat1) == -1) {
-        perror("stat failed for file_path1"); // Print error if stat fails
-        return 1; // Return positive number to indicate error
+/**
+ * @brief Makes room for `length` more bytes in the name arena of a table.
+ *
+ * When the arena moves, the names and sort keys of the stored entries are rebased.
+ *
+ * @param table Table whose arena is grown.
+ * @param length Number of bytes about to be appended.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+static int entry_table_reserve_names(struct ls_entry_table *table, size_t length) {
+    size_t new_capacity;
+    char *new_names;
+
+    if (table->names_used + length <= table->names_capacity) {
+        return 0;
+    }
+    new_capacity = table->names_capacity ? table->names_capacity : INITIAL_NAME_CAPACITY;
+    while (table->names_used + length > new_capacity) {
+        new_capacity *= 2;
     }
+    new_names = realloc(table->names, new_capacity);
+    if (new_names == NULL) {
+        perror("realloc failed");
+        return -1;
+    }
+    // Rebase the names and keys of the entries already stored
+    if (new_names != table->names) {
+        for (size_t i = 0; i < table->count; i++) {
+            struct ls_entry *entry = &table->entries[i];
+            entry->name = new_names + entry->name_offset;
+            if (entry->sort_key != NULL) {
+                entry->sort_key = new_names + entry->sort_key_offset;
+            }
+        }
+    }
+    table->names = new_names;
+    table->names_capacity = new_capacity;
+    return 0;
+}
 
-     // Construct full path for the second file
-    snprintf(full_path2, sizeof(full_path2), "%s/%s", dir, *(const char **)b);
+/**
+ * @brief Appends an entry to the table and copies its name into the name arena.
+ *
+ * Both the entry vector and the name arena grow geometrically, so a directory
+ * of any size costs a handful of reallocations instead of one allocation per name.
+ * When the arena moves, the name pointers of the existing entries are rebased.
+ *
+ * @param table Table to append to.
+ * @param name Name of the entry (does not need to be NUL-terminated).
+ * @param name_length Length of the name in bytes.
+ * @return struct ls_entry* The new entry with only its name set, or NULL on allocation failure.
+ */
+struct ls_entry *entry_table_add(struct ls_entry_table *table, const char *name, size_t name_length) {
+    struct ls_entry *entry;     // Entry being appended
+
+    // Grow the entry vector if it is full
+    if (table->count == table->capacity) {
+        size_t new_capacity = table->capacity ? table->capacity * 2 : INITIAL_ENTRY_CAPACITY;
+        struct ls_entry *new_entries = realloc(table->entries, new_capacity * sizeof(struct ls_entry));
+        if (new_entries == NULL) {
+            perror("realloc failed");
+            return NULL;
+        }
+        table->entries = new_entries;
+        table->capacity = new_capacity;
+    }
 
-    // Get file stats for the second file
-    if (stat(full_path2, &file_stat2) == -1) {
-        perror("stat failed for file_path2"); // Print error if stat fails
-        return -1; // Return negative number to indicate error
+    // Grow the name arena if the name (plus its terminator) does not fit
+    if (entry_table_reserve_names(table, name_length + 1) == -1) {
+        return NULL;
     }
 
-    // Get file st
-    // Compare the ctime (status change time) of the two files
-    if (file_stat1.st_ctime > file_stat2.st_ctime) {
-        return -1; // file_path1 is newer
-    } else if (file_stat1.st_ctime < file_stat2.st_ctime) {
-        return 1;  // file_path1 is older
+    entry = &table->entries[table->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->name_offset = table->names_used;
+    entry->name = table->names + entry->name_offset;
+    memcpy(entry->name, name, name_length);
+    entry->name[name_length] = '\0';
+    table->names_used += name_length + 1;
+    return entry;
+}
+
+/**
+ * @brief Computes the key the name sort compares for every entry of a table.
+ *
+ * Each key is built once and stored in the name arena, so sorting compares
+ * prepared keys with a single memcmp instead of folding both names on every
+ * comparison. By default the key is the name with ASCII letters lowercased;
+ * with `--collate` it is the `strxfrm` transform of the name for the
+ * LC_COLLATE locale, which orders the same way `strcoll` would.
+ *
+ * @param table Table whose entries get their keys; entries that already have one are skipped.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int entry_table_prepare_sort_keys(struct ls_entry_table *table) {
+    for (size_t i = 0; i < table->count; i++) {
+        struct ls_entry *entry = &table->entries[i];
+        size_t key_length;      // Length of the key without its terminator
+        char *key;              // Key being written into the arena
+
+        if (entry->sort_key != NULL) {
+            continue;
+        }
+        if (is_collate_enabled == 1) {
+            key_length = strxfrm(NULL, entry->name, 0);
+        } else {
+            key_length = strlen(entry->name);
+        }
+        if (entry_table_reserve_names(table, key_length + 1) == -1) {
+            return -1;
+        }
+
+        key = table->names + table->names_used;
+        if (is_collate_enabled == 1) {
+            strxfrm(key, entry->name, key_length + 1);
+        } else {
+            for (size_t j = 0; j <= key_length; j++) {
+                key[j] = (char)tolower((unsigned char)entry->name[j]);
+            }
+        }
+        entry->sort_key_offset = table->names_used;
+        entry->sort_key = key;
+        entry->sort_key_length = key_length;
+        table->names_used += key_length + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Releases the memory and the directory descriptor owned by an entry table.
+ *
+ * @param table Table to release; it is left empty and can be reused.
+ */
+void entry_table_free(struct ls_entry_table *table) {
+    if (table->dir_fd != -1) {
+        close(table->dir_fd);
+    }
+    free(table->entries);
+    free(table->names);
+    entry_table_init(table);
+}
+
+/**
+ * @brief Prepares a getdents64 reader over an open directory.
+ *
+ * The buffer is supplied by the caller so that large directories can be read
+ * with megabyte-sized buffers and therefore very few system calls.
+ *
+ * @param reader Reader to initialize.
+ * @param fd Open directory file descriptor.
+ * @param buffer Buffer receiving the raw directory records.
+ * @param buffer_size Size of the buffer in bytes.
+ */
+void dirent_reader_init(struct dirent_reader *reader, int fd, char *buffer, size_t buffer_size) {
+    reader->fd = fd;
+    reader->buffer = buffer;
+    reader->buffer_size = buffer_size;
+    reader->position = 0;
+    reader->length = 0;
+}
+
+/**
+ * @brief Reads the next batch of directory records with one getdents64 call.
+ *
+ * @param reader Reader to refill; records left over from the previous batch are discarded.
+ * @return ssize_t Number of bytes read, 0 at the end of the directory, -1 on error.
+ */
+ssize_t dirent_reader_fill(struct dirent_reader *reader) {
+    long bytes_read = syscall(SYS_getdents64, reader->fd, reader->buffer, reader->buffer_size);
+
+    if (bytes_read == -1) {
+        perror("getdents64 failed");
+        reader->length = 0;
     } else {
-        return 0;  // Both files have the same ctime
+        reader->length = (size_t)bytes_read;
     }
+    reader->position = 0;
+    return bytes_read;
 }
 
 /**
- * @brief Comparison function for qsort to sort files by their last access time, newest first.
- * 
- * This function compares the access time (`atime`) of two files and 
- * sorts them in descending order (newest first). If the access time 
- * is the same, it falls back to lexicographical comparison by file name.
+ * @brief Parses the next record of the current batch in place.
  *
- * @param a Pointer to the first file path (const void* for qsort compatibility).
- * @param b Pointer to the second file path (const void* for qsort compatibility).
- * @return int 1 if file a is older, -1 if file a is newer, 0 if access times are the same.
+ * @param reader Reader holding the current batch.
+ * @param dirent Filled with the name, type and inode of the record.
+ * @return int 1 if a record was returned, 0 if the batch is exhausted.
  */
-int compare_by_access_time(const void *a, const void *b) {
-    struct stat file_stat1, file_stat2;
-    char full_path1[PATH_MAX], full_path2[PATH_MAX];
-    
-    // Construct full path for the first file
-    snprintf(full_path1, sizeof(full_path1), "%s/%s", dir, *(const char **)a);
-    if (stat(full_path1, &file_stat1) == -1) {
-        perror("stat failed for file_stat1");
-        return 1;  // Assume this file is older if stat fails
+int dirent_reader_next(struct dirent_reader *reader, struct ls_dirent *dirent) {
+    struct linux_dirent64 *record;      // Record at the current position
+
+    if (reader->position >= reader->length) {
+        return 0;
+    }
+    record = (struct linux_dirent64 *)(reader->buffer + reader->position);
+    reader->position += record->d_reclen;
+
+    dirent->name = record->d_name;
+    dirent->name_length = strlen(record->d_name);
+    dirent->type = record->d_type;
+    dirent->inode = (ino_t)record->d_ino;
+    return 1;
+}
+
+/**
+ * @brief Reads every visible entry of a directory into an entry table.
+ *
+ * Hidden entries are skipped unless `-a` or `-f` is active. Each entry gets its
+ * name, `d_type` and `d_ino` straight from the getdents64 records; no metadata
+ * is loaded here.
+ *
+ * @param table Table receiving the entries, read from its open `dir_fd`.
+ * @return int 0 on success, -1 if reading failed or memory ran out.
+ */
+int read_directory_entries(struct ls_entry_table *table) {
+    struct dirent_reader reader;        // getdents64 reader over the directory
+    struct ls_dirent dirent;            // Current raw entry
+    struct ls_entry *entry;             // Entry added to the table
+    char *buffer;                       // Buffer for the raw directory records
+    ssize_t bytes_read;                 // Result of the last batch read
+    int result = 0;
+
+    buffer = malloc(dirent_buffer_size);
+    if (buffer == NULL) {
+        perror("malloc failed");
+        return -1;
+    }
+    dirent_reader_init(&reader, table->dir_fd, buffer, dirent_buffer_size);
+
+    while ((bytes_read = dirent_reader_fill(&reader)) > 0) {
+        while (dirent_reader_next(&reader, &dirent)) {
+            // Skip hidden files if the hiddenfiles_flag is not set
+            if (dirent.name[0] == '.' && is_hidden_files_enabled == 0 && is_no_sort_enabled == 0) {
+                continue;
+            }
+            entry = entry_table_add(table, dirent.name, dirent.name_length);
+            if (entry == NULL) {
+                free(buffer);
+                return -1;
+            }
+            entry->d_type = dirent.type;
+            entry->inode = dirent.inode;
+        }
+    }
+    if (bytes_read == -1) {
+        result = -1;
+    }
+
+    free(buffer);
+    return result;
+}
+
+/**
+ * @brief Computes the statx fields the active options actually print or sort on.
+ *
+ * Asking only for these fields lets network and FUSE filesystems skip
+ * revalidating attributes that would never be shown.
+ *
+ * @return unsigned int STATX_* mask for the current listing.
+ */
+static unsigned int listing_statx_mask(void) {
+    unsigned int mask = COLOR_STATX_MASK;
+
+    if (is_inode_enabled == 1) {
+        mask |= STATX_INO;
+    }
+    if (is_sort_by_time_enabled == 1 || is_sort_by_access_time_enabled == 1 || top_entry_count > 0) {
+        mask |= STATX_MTIME;  // Time sorts order by modification time
+    }
+    if (is_ctime_option_enabled == 1) {
+        mask |= STATX_CTIME;
     }
+    if (is_long_format_enabled == 1) {
+        mask |= STATX_NLINK | STATX_UID | STATX_GID | STATX_SIZE | STATX_BLOCKS | STATX_MTIME;
+    }
+    return mask;
+}
 
-    // Construct full path for the second file
-    snprintf(full_path2, sizeof(full_path2), "%s/%s", dir, *(const char **)b);
-    if (stat(full_path2, &file_stat2) == -1) {
-        perror("stat failed for file_stat2");
-        return -1; // Assume this file is older if stat fails
+/**
+ * @brief Copies the fields a statx call returned into an entry record.
+ *
+ * Fields the filesystem did not return are left untouched, so for example
+ * the inode reported by the directory survives when STATX_INO was not asked for.
+ *
+ * @param entry Record to fill.
+ * @param file_statx Result of statx.
+ */
+void fill_entry_from_statx(struct ls_entry *entry, const struct statx *file_statx) {
+    unsigned int mask = file_statx->stx_mask;   // Fields that are valid
+
+    entry->mode = file_statx->stx_mode;
+    if (mask & STATX_SIZE) entry->size = (off_t)file_statx->stx_size;
+    if (mask & STATX_BLOCKS) entry->blocks = (blkcnt_t)file_statx->stx_blocks;
+    if (mask & STATX_ATIME) {
+        entry->atime.tv_sec = file_statx->stx_atime.tv_sec;
+        entry->atime.tv_nsec = file_statx->stx_atime.tv_nsec;
+    }
+    if (mask & STATX_MTIME) {
+        entry->mtime.tv_sec = file_statx->stx_mtime.tv_sec;
+        entry->mtime.tv_nsec = file_statx->stx_mtime.tv_nsec;
     }
+    if (mask & STATX_CTIME) {
+        entry->ctime.tv_sec = file_statx->stx_ctime.tv_sec;
+        entry->ctime.tv_nsec = file_statx->stx_ctime.tv_nsec;
+    }
+    if (mask & STATX_INO) entry->inode = (ino_t)file_statx->stx_ino;
+    if (mask & STATX_NLINK) entry->nlink = file_statx->stx_nlink;
+    if (mask & STATX_UID) entry->uid = file_statx->stx_uid;
+    if (mask & STATX_GID) entry->gid = file_statx->stx_gid;
+}
+
+/**
+ * @brief Returns the AT_* flags used for every statx call.
+ *
+ * @return int AT_SYMLINK_NOFOLLOW, plus AT_STATX_DONT_SYNC with `--no-sync`.
+ */
+static int listing_statx_flags(void) {
+    int flags = AT_SYMLINK_NOFOLLOW;
+
+    if (is_dont_sync_enabled == 1) {
+        flags |= AT_STATX_DONT_SYNC;
+    }
+    return flags;
+}
+
+/**
+ * @brief Fills an entry record with the metadata of a directory entry.
+ *
+ * The entry is stat'ed exactly once here, relative to its already open
+ * directory, so the kernel does not re-walk the full path for every entry.
+ * Only the fields in `mask` are requested from statx; with `--no-sync` the
+ * filesystem may answer from its attribute cache. Kernels without statx fall
+ * back to fstatat. Symbolic links are described by themselves, not by their targets.
+ *
+ * @param dir_fd Open directory containing the entry, or AT_FDCWD if `name` is a path.
+ * @param name Name of the entry inside the directory.
+ * @param mask STATX_* fields needed by the caller.
+ * @param entry Record to fill (its name is left to the caller).
+ * @return int 0 on success, -1 if the entry could not be stat'ed.
+ */
+int load_entry(int dir_fd, const char *name, unsigned int mask, struct ls_entry *entry) {
+    struct statx file_statx;        // Requested metadata of the entry
+    struct stat file_stat;          // Metadata of the entry when statx is unavailable
+
+    if (__atomic_load_n(&is_statx_unsupported, __ATOMIC_RELAXED) == 0) {
+        if (statx(dir_fd, name, listing_statx_flags(), mask, &file_statx) == 0) {
+            fill_entry_from_statx(entry, &file_statx);
+            entry->is_loaded = 1;
+            return 0;
+        }
+        if (errno != ENOSYS) {
+            perror("stat failed");
+            return -1;
+        }
+        __atomic_store_n(&is_statx_unsupported, 1, __ATOMIC_RELAXED);
+    }
+
+    if (fstatat(dir_fd, name, &file_stat, AT_SYMLINK_NOFOLLOW) == -1) {
+        perror("stat failed");
+        return -1;
+    }
+
+    entry->mode = file_stat.st_mode;
+    entry->size = file_stat.st_size;
+    entry->blocks = file_stat.st_blocks;
+    entry->atime = file_stat.st_atim;
+    entry->mtime = file_stat.st_mtim;
+    entry->ctime = file_stat.st_ctim;
+    entry->inode = file_stat.st_ino;
+    entry->nlink = file_stat.st_nlink;
+    entry->uid = file_stat.st_uid;
+    entry->gid = file_stat.st_gid;
+    entry->is_loaded = 1;
+    return 0;
+}
+
+/**
+ * @brief Loads the metadata of one slice of a table; run by the worker pool.
+ *
+ * @param begin First entry of the slice.
+ * @param end One past the last entry of the slice.
+ * @param arg The shared load (struct metadata_load).
+ */
+static void load_metadata_range(size_t begin, size_t end, void *arg) {
+    struct metadata_load *load = arg;
+
+    for (size_t i = begin; i < end; i++) {
+        load_entry(load->table->dir_fd, load->table->entries[i].name, load->mask, &load->table->entries[i]);
+    }
+}
+
+/**
+ * @brief Loads the metadata of every entry in a table.
+ *
+ * Large tables are loaded with batched statx requests through io_uring when
+ * the kernel allows it. Otherwise the table is split across the worker pool so
+ * that high-latency filesystems are queried from several threads at once, and
+ * small tables are simply stat'ed in turn. Entries that cannot be stat'ed (for
+ * example because they vanished after the directory was read) are reported
+ * and dropped from the table.
+ *
+ * @param table Table whose entries are loaded relative to its `dir_fd`.
+ */
+static void load_table_metadata(struct ls_entry_table *table) {
+    struct metadata_load load = { table, listing_statx_mask() };
+    size_t kept = 0;    // Number of entries successfully loaded so far
+
+    if (is_io_uring_enabled == 0 || __atomic_load_n(&is_statx_unsupported, __ATOMIC_RELAXED) == 1 ||
+        table->count < URING_MIN_ENTRIES ||
+        uring_load_table_metadata(table, load.mask, listing_statx_flags()) == -1) {
+        if (table->count >= PARALLEL_STAT_MIN_ENTRIES) {
+            pool_parallel_for(table->count, PARALLEL_STAT_MIN_CHUNK, load_metadata_range, &load);
+        } else {
+            load_metadata_range(0, table->count, &load);
+        }
+    }
+
+    // Drop the entries that could not be loaded
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->entries[i].is_loaded == 0) {
+            continue;
+        }
+        if (kept != i) {
+            table->entries[kept] = table->entries[i];
+        }
+        kept++;
+    }
+    table->count = kept;
+}
+
+/**
+ * @brief Comparison function for qsort to compare entries by their change time (ctime).
+ * 
+ * This function compares the preloaded ctime (status change time) of two entries,
+ * to the nanosecond. It returns -1 if the first entry's ctime is more recent and
+ * 1 if it is older; entries with the same ctime are ordered by name.
+ *
+ * @param a Pointer to the first entry record (const void* for qsort compatibility).
+ * @param b Pointer to the second entry record (const void* for qsort compatibility).
+ * @return int -1 if the first entry is more recent, 1 if older, otherwise the name order.
+ */
+int compare_by_ctime(const void *a, const void *b) {
+    const struct ls_entry *entry1 = a;
+    const struct ls_entry *entry2 = b;
+
+    // Compare the ctime (status change time) of the two entries
+    if (entry1->ctime.tv_sec != entry2->ctime.tv_sec) {
+        return entry1->ctime.tv_sec > entry2->ctime.tv_sec ? -1 : 1;  // Newer first
+    }
+    if (entry1->ctime.tv_nsec != entry2->ctime.tv_nsec) {
+        return entry1->ctime.tv_nsec > entry2->ctime.tv_nsec ? -1 : 1;
+    }
+    return strcmp(entry1->name, entry2->name);
+}
+
+/**
+ * @brief Comparison function for qsort to sort entries by time, newest first.
+ * 
+ * This function compares the preloaded modification time of two entries, to the
+ * nanosecond, and sorts them in descending order (newest first). If the times are
+ * the same, it falls back to lexicographical comparison by file name.
+ *
+ * @param a Pointer to the first entry record (const void* for qsort compatibility).
+ * @param b Pointer to the second entry record (const void* for qsort compatibility).
+ * @return int 1 if entry a is older, -1 if entry a is newer, otherwise the name order.
+ */
+int compare_by_access_time(const void *a, const void *b) {
+    const struct ls_entry *entry1 = a;
+    const struct ls_entry *entry2 = b;
 
     // Compare modification times (st_mtime) in descending order (newest first)
-    if (file_stat1.st_mtime > file_stat2.st_mtime) {
-        return -1; // file_stat1 is newer, should come first
-    } else if (file_stat1.st_mtime < file_stat2.st_mtime) {
-        return 1;  // file_stat2 is newer, should come first
+    if (entry1->mtime.tv_sec != entry2->mtime.tv_sec) {
+        return entry1->mtime.tv_sec > entry2->mtime.tv_sec ? -1 : 1;
+    }
+    if (entry1->mtime.tv_nsec != entry2->mtime.tv_nsec) {
+        return entry1->mtime.tv_nsec > entry2->mtime.tv_nsec ? -1 : 1;
     }
 
     // If modification times are equal, compare lexicographically by file name
-    return strcmp(*(const char **)a, *(const char **)b);
+    return strcmp(entry1->name, entry2->name);
 }
 
 /**
  * @brief Case-insensitive comparison function for qsort.
  * 
- * This function compares two strings (file names) in a case-insensitive 
- * manner. It converts both strings to lowercase before performing the comparison.
+ * This function compares the prepared sort keys of two entries (see
+ * `entry_table_prepare_sort_keys`). Both keys end in a NUL byte, so one
+ * memcmp covering the shorter key and its terminator orders them exactly
+ * like strcmp would.
  *
- * @param p1 Pointer to the first string (const void* for qsort compatibility).
- * @param p2 Pointer to the second string (const void* for qsort compatibility).
+ * @param p1 Pointer to the first entry record (const void* for qsort compatibility).
+ * @param p2 Pointer to the second entry record (const void* for qsort compatibility).
  * @return int Negative if p1 < p2, positive if p1 > p2, 0 if they are equal.
  */
 static int compare_case_insensitive(const void *p1, const void *p2) {
-    const char *file_name1 = *(const char **)p1;
-    const char *file_name2 = *(const char **)p2;
-
-    // Buffers to store lowercase versions of the file names
-    char lower_file_name1[1024], lower_file_name2[1024];
+    const struct ls_entry *entry1 = p1;
+    const struct ls_entry *entry2 = p2;
+    size_t length = entry1->sort_key_length < entry2->sort_key_length ? entry1->sort_key_length : entry2->sort_key_length;
 
-    // Copy original names to temporary buffers
-    strcpy(lower_file_name1, file_name1);
-    strcpy(lower_file_name2, file_name2);
+    return memcmp(entry1->sort_key, entry2->sort_key, length + 1);
+}
 
-    // Convert file_name1 to lowercase
-    for (int i = 0; lower_file_name1[i]; i++) {
-        lower_file_name1[i] = tolower(lower_file_name1[i]);
+/**
+ * @brief Sorts the entries of a table by name, ignoring case.
+ *
+ * The sort keys are prepared once and sorted with the radix sort engine, or
+ * with qsort when `--sort-engine=qsort` is given or the radix sort runs out of memory.
+ *
+ * @param table Table to sort.
+ */
+static void sort_entries_by_name(struct ls_entry_table *table) {
+    if (entry_table_prepare_sort_keys(table) == -1) {
+        return;
     }
-
-    // Convert file_name2 to lowercase
-    for (int i = 0; lower_file_name2[i]; i++) {
-        lower_file_name2[i] = tolower(lower_file_name2[i]);
+    if (is_radix_sort_enabled == 0 || radix_sort_entries(table) == -1) {
+        qsort(table->entries, table->count, sizeof(struct ls_entry), compare_case_insensitive);
     }
+}
 
-    // Compare the lowercase versions of the file names
-    return strcmp(lower_file_name1, lower_file_name2);
+/**
+ * @brief Sorts the entries of a table newest first, breaking ties by name.
+ *
+ * Uses the radix sort engine over packed timestamps, or qsort when
+ * `--sort-engine=qsort` is given or the radix sort runs out of memory.
+ *
+ * @param table Table whose timestamps are loaded.
+ * @param by_change_time Nonzero to sort by status change time, zero for modification time.
+ */
+static void sort_entries_by_time(struct ls_entry_table *table, int by_change_time) {
+    if (is_radix_sort_enabled == 0 || radix_sort_entries_by_time(table, by_change_time) == -1) {
+        qsort(table->entries, table->count, sizeof(struct ls_entry),
+              by_change_time ? compare_by_ctime : compare_by_access_time);
+    }
 }
 
 /**
@@ -156,13 +722,13 @@ static int compare_case_insensitive(const void *p1, const void *p2) {
  * are always prioritized at the top of the list. For other files, it performs a 
  * standard lexicographical comparison.
  * 
- * @param a Pointer to the first file path (const void* for qsort compatibility).
- * @param b Pointer to the second file path (const void* for qsort compatibility).
+ * @param a Pointer to the first entry record (const void* for qsort compatibility).
+ * @param b Pointer to the second entry record (const void* for qsort compatibility).
  * @return int Negative if a < b, positive if a > b, 0 if they are equal.
  */
 int compare_with_hidden(const void *a, const void *b) {
-    const char *file_name1 = *(const char **)a;  // Dereference and get the first file name
-    const char *file_name2 = *(const char **)b;  // Dereference and get the second file name
+    const char *file_name1 = ((const struct ls_entry *)a)->name;  // Name of the first entry
+    const char *file_name2 = ((const struct ls_entry *)b)->name;  // Name of the second entry
 
     // Special case: prioritize '.' and '..' at the top of the list
     if (strcmp(file_name1, ".") == 0) return -1;  // '.' should come first
@@ -175,185 +741,875 @@ int compare_with_hidden(const void *a, const void *b) {
 }
 
 /**
- * @brief Simple lexicographical comparison function for qsort.
- * 
- * This function compares two file names in lexicographical order, without
- * any special handling for hidden files or case sensitivity.
- * 
- * @param a Pointer to the first file path (const void* for qsort compatibility).
- * @param b Pointer to the second file path (const void* for qsort compatibility).
- * @return int Negative if a < b, positive if a > b, 0 if they are equal.
+ * @brief Simple lexicographical comparison function for qsort.
+ * 
+ * This function compares two file names in lexicographical order, without
+ * any special handling for hidden files or case sensitivity.
+ * 
+ * @param a Pointer to the first file path (const void* for qsort compatibility).
+ * @param b Pointer to the second file path (const void* for qsort compatibility).
+ * @return int Negative if a < b, positive if a > b, 0 if they are equal.
+ */
+int compare(const void *a, const void *b) {
+    // Perform a simple lexicographical comparison of the two file names
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/**
+ * @brief Prints a name in a color, followed by a suffix.
+ *
+ * @param color Escape sequence selecting the color, or NULL for the default color.
+ * @param name Name to print.
+ * @param suffix Text printed after the name ("   " or a newline).
+ */
+static void print_colored(const char *color, const char *name, const char *suffix) {
+    if (color != NULL) {
+        out_puts(out_current, color);
+        out_puts(out_current, name);
+        out_puts(out_current, COLOR_RESET);
+    } else {
+        out_puts(out_current, name);
+    }
+    out_puts(out_current, suffix);
+}
+
+/**
+ * @brief Prints a cyan symbolic link name followed by its target.
+ *
+ * @param file_name Name of the link.
+ * @param target_color Color of the target, or NULL for the default color.
+ * @param target_path Target the link points to.
+ * @param suffix Text printed after the target.
+ */
+static void print_colored_link(const char *file_name, const char *target_color, const char *target_path,
+                               const char *suffix) {
+    print_colored(COLOR_LINK, file_name, " -> ");
+    print_colored(target_color, target_path, suffix);
+}
+
+/**
+ * @brief Prints a symbolic link name followed by its target, without colors.
+ *
+ * @param file_name Name of the link.
+ * @param target_path Target the link points to.
+ * @param suffix Text printed after the target.
+ */
+static void print_plain_link(const char *file_name, const char *target_path, const char *suffix) {
+    print_colored(NULL, file_name, " -> ");
+    print_colored(NULL, target_path, suffix);
+}
+
+/**
+ * @brief Hashes the key of a link target (FNV-1a over the directory and the target text).
+ *
+ * @param dir_dev Device of the directory holding the link, 0 for absolute targets.
+ * @param dir_ino Inode of the directory holding the link, 0 for absolute targets.
+ * @param target Target text.
+ * @return size_t Hash of the key.
+ */
+static size_t link_target_hash(dev_t dir_dev, ino_t dir_ino, const char *target) {
+    uint64_t hash = 14695981039346656037ULL;   // FNV-1a offset basis
+
+    hash = (hash ^ (uint64_t)dir_dev) * 1099511628211ULL;
+    hash = (hash ^ (uint64_t)dir_ino) * 1099511628211ULL;
+    for (const unsigned char *c = (const unsigned char *)target; *c != '\0'; c++) {
+        hash = (hash ^ *c) * 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+/**
+ * @brief Finds the slot of a key in the link target cache. The cache lock must be held.
+ *
+ * @param cache Cache to search; it must have at least one free slot.
+ * @param hash Hash of the key.
+ * @param dir_dev Device of the directory holding the link.
+ * @param dir_ino Inode of the directory holding the link.
+ * @param target Target text.
+ * @return struct link_target* The slot holding the key, or the free slot where it belongs.
+ */
+static struct link_target *link_target_slot(struct link_target_cache *cache, size_t hash, dev_t dir_dev,
+                                            ino_t dir_ino, const char *target) {
+    size_t index = hash & (cache->capacity - 1);
+
+    while (cache->slots[index].target != NULL &&
+           (cache->slots[index].hash != hash || cache->slots[index].dir_dev != dir_dev ||
+            cache->slots[index].dir_ino != dir_ino || strcmp(cache->slots[index].target, target) != 0)) {
+        index = (index + 1) & (cache->capacity - 1);
+    }
+    return &cache->slots[index];
+}
+
+/**
+ * @brief Doubles the number of slots of the link target cache. The cache lock must be held.
+ *
+ * @param cache Cache to grow.
+ * @return int 0 on success, -1 if memory ran out.
+ */
+static int link_target_grow(struct link_target_cache *cache) {
+    struct link_target *old_slots = cache->slots;
+    size_t old_capacity = cache->capacity;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : INITIAL_LINK_CACHE_CAPACITY;
+    struct link_target *new_slots = calloc(new_capacity, sizeof(struct link_target));
+
+    if (new_slots == NULL) {
+        return -1;
+    }
+    cache->slots = new_slots;
+    cache->capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].target != NULL) {
+            struct link_target *slot = &old_slots[i];
+            *link_target_slot(cache, slot->hash, slot->dir_dev, slot->dir_ino, slot->target) = *slot;
+        }
+    }
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * @brief Returns the device and inode of the directory holding a link.
+ *
+ * For the directory being listed they are fetched on the first link with a
+ * relative target and reused for every other link of the listing; other
+ * directories (the parent of a path operand) are stat'ed directly.
+ *
+ * @param dir_fd Open directory holding the link, or AT_FDCWD.
+ * @param dev Receives the device of the directory.
+ * @param ino Receives the inode of the directory.
+ * @return int 0 on success, -1 if the directory could not be stat'ed.
+ */
+static int link_directory_identity(int dir_fd, dev_t *dev, ino_t *ino) {
+    struct stat info;       // Metadata of the directory
+
+    if (dir_fd != listing_directory.fd || listing_directory.is_known == 0) {
+        if (fstatat(dir_fd, "", &info, AT_EMPTY_PATH) == -1) {
+            return -1;
+        }
+        if (dir_fd != listing_directory.fd) {
+            *dev = info.st_dev;
+            *ino = info.st_ino;
+            return 0;
+        }
+        listing_directory.dev = info.st_dev;
+        listing_directory.ino = info.st_ino;
+        listing_directory.is_known = 1;
+    }
+    *dev = listing_directory.dev;
+    *ino = listing_directory.ino;
+    return 0;
+}
+
+/**
+ * @brief Returns the type of a symbolic link's target, stat'ing each distinct target only once.
+ *
+ * Trees such as /usr/lib or node_modules hold thousands of links to a handful
+ * of targets; every link after the first one to a target is answered from the
+ * cache. Targets that cannot be stat'ed are cached too. The target itself is
+ * stat'ed without the cache lock held, so threads never wait on each other's I/O.
+ *
+ * @param dir_fd Open directory holding the link, or AT_FDCWD.
+ * @param target Target text read from the link.
+ * @param mode Receives the type and permissions of the target.
+ * @return int 0 on success, -1 if the target could not be stat'ed.
+ */
+static int cached_link_target_mode(int dir_fd, const char *target, mode_t *mode) {
+    struct stat info;               // Metadata of the directory, then of the target
+    struct link_target *slot;
+    dev_t dir_dev = 0;
+    ino_t dir_ino = 0;
+    size_t hash;
+    mode_t target_mode = 0;
+
+    // A relative target depends on the directory holding the link
+    if (target[0] != '/' && link_directory_identity(dir_fd, &dir_dev, &dir_ino) == -1) {
+        if (fstatat(dir_fd, target, &info, AT_SYMLINK_NOFOLLOW) == -1) {
+            return -1;
+        }
+        *mode = info.st_mode;
+        return 0;
+    }
+    hash = link_target_hash(dir_dev, dir_ino, target);
+
+    pthread_mutex_lock(&link_target_cache.lock);
+    if (link_target_cache.capacity > 0) {
+        slot = link_target_slot(&link_target_cache, hash, dir_dev, dir_ino, target);
+        if (slot->target != NULL) {
+            target_mode = slot->mode;
+            pthread_mutex_unlock(&link_target_cache.lock);
+            *mode = target_mode;
+            return target_mode != 0 ? 0 : -1;
+        }
+    }
+    pthread_mutex_unlock(&link_target_cache.lock);
+
+    if (fstatat(dir_fd, target, &info, AT_SYMLINK_NOFOLLOW) == 0) {
+        target_mode = info.st_mode;
+    }
+
+    // Remember the result; if another thread got there first its result is the same
+    pthread_mutex_lock(&link_target_cache.lock);
+    if ((link_target_cache.count + 1) * 2 <= link_target_cache.capacity ||
+        link_target_grow(&link_target_cache) == 0) {
+        slot = link_target_slot(&link_target_cache, hash, dir_dev, dir_ino, target);
+        if (slot->target == NULL) {
+            slot->target = strdup(target);
+            if (slot->target != NULL) {
+                slot->dir_dev = dir_dev;
+                slot->dir_ino = dir_ino;
+                slot->hash = hash;
+                slot->mode = target_mode;
+                link_target_cache.count++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&link_target_cache.lock);
+
+    *mode = target_mode;
+    return target_mode != 0 ? 0 : -1;
+}
+
+/**
+ * @brief Prints a symbolic link followed by its target, colored by the target's type.
+ *
+ * The link is read and its target inspected relative to the directory that
+ * holds the link, so relative targets resolve the same way the kernel does.
+ *
+ * @param dir_fd Open directory containing the link, or AT_FDCWD.
+ * @param link_path Path of the link relative to `dir_fd`.
+ * @param file_name Name printed for the link.
+ * @param suffix Text printed after the link ("   " or a newline).
+ */
+static void print_link_with_target(int dir_fd, const char *link_path, const char *file_name, const char *suffix) {
+    mode_t target_mode;           // Type and permissions of the symlink target
+    char target_path[PATH_MAX];   // Buffer to store the target of the symbolic link
+    ssize_t link_length;          // Length of the symbolic link target path
+
+    link_length = readlinkat(dir_fd, link_path, target_path, sizeof(target_path) - 1);
+    if (link_length == -1) {
+        if (is_no_sort_enabled == 1) {
+            print_colored(NULL, file_name, suffix);
+        } else {
+            print_colored(COLOR_LINK, file_name, suffix);  // Cyan for symlink if target retrieval fails
+        }
+        return;
+    }
+    target_path[link_length] = '\0'; // Null-terminate the target path
+
+    if (is_no_sort_enabled == 1) {
+        print_plain_link(file_name, target_path, suffix); // No colors without sorting
+    } else if (cached_link_target_mode(dir_fd, target_path, &target_mode) == -1) {
+        // If target info cannot be retrieved, print the link without coloring the target
+        print_colored_link(file_name, NULL, target_path, suffix);
+    } else if (S_ISDIR(target_mode)) {
+        print_colored_link(file_name, COLOR_DIRECTORY, target_path, suffix);  // Blue for directory target
+    } else if (target_mode & S_IXUSR) {
+        print_colored_link(file_name, COLOR_EXECUTABLE, target_path, suffix);  // Green for executable target
+    } else {
+        print_colored_link(file_name, NULL, target_path, suffix);  // Default for regular target
+    }
+}
+
+/**
+ * @brief Prints a symbolic link given by path, followed by its target.
+ *
+ * A relative target is relative to the directory holding the link, so the
+ * link is read and its target inspected through a descriptor of that
+ * directory rather than by resolving the whole path with realpath().
+ *
+ * @param path Path of the link.
+ * @param file_name Name printed for the link.
+ * @param suffix Text printed after the link ("   " or a newline).
+ */
+static void print_path_link(const char *path, const char *file_name, const char *suffix) {
+    const char *slash = strrchr(path, '/');    // End of the directory part of the path
+    char parent[PATH_MAX];                      // Directory holding the link
+    size_t parent_length;
+    int parent_fd;
+
+    if (slash == NULL) {
+        print_link_with_target(AT_FDCWD, path, file_name, suffix);  // The link is in the working directory
+        return;
+    }
+    parent_length = slash == path ? 1 : (size_t)(slash - path);    // Keep the "/" of a link in the root
+    if (parent_length >= sizeof(parent)) {
+        print_link_with_target(AT_FDCWD, path, file_name, suffix);
+        return;
+    }
+    memcpy(parent, path, parent_length);
+    parent[parent_length] = '\0';
+
+    parent_fd = open(parent, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (parent_fd == -1) {
+        print_link_with_target(AT_FDCWD, path, file_name, suffix);
+        return;
+    }
+    print_link_with_target(parent_fd, slash + 1, file_name, suffix);
+    close(parent_fd);
+}
+
+/**
+ * @brief Prints a file or directory name given by path, colored by its type.
+ *
+ * The path is stat'ed once. Only symbolic links in a long listing go on to
+ * read their target (see `print_path_link`).
+ *
+ * @param path Path to the file or directory.
+ * @param suffix Text printed after the name ("   " or a newline).
+ */
+static void print_path_with_color(char *path, const char *suffix) {
+    struct stat file_info;        // Structure to hold information about the file/directory
+    char *file_name;              // Base name or full path of the file
+
+    // Get the base name of the path (or the full path if necessary)
+    file_name = basename(path);
+
+    // Retrieve file or directory information using lstat
+    if (lstat(path, &file_info) == -1) {
+        perror("Failed to retrieve file information");
+        return; // Exit the function if an error occurs
+    }
+
+    if (S_ISLNK(file_info.st_mode) && is_long_format_enabled == 1) {
+        print_path_link(path, file_name, suffix);  // Cyan link and its target
+    } else if (is_no_sort_enabled == 1) {
+        print_colored(NULL, file_name, suffix);  // No colors without sorting
+    } else if (S_ISDIR(file_info.st_mode)) {
+        print_colored(COLOR_DIRECTORY, file_name, suffix);  // Blue for directories
+    } else if (S_ISLNK(file_info.st_mode)) {
+        print_colored(COLOR_LINK, file_name, suffix);  // Cyan for symbolic links
+    } else if (file_info.st_mode & S_IXUSR) {
+        print_colored(COLOR_EXECUTABLE, file_name, suffix);  // Green for executables
+    } else {
+        print_colored(NULL, file_name, suffix);  // Default color for regular files
+    }
+}
+
+/**
+ * @brief Prints a file or directory name with appropriate colors based on its type.
+ *
+ * This function prints file or directory names in color depending on their type:
+ * - Blue for directories
+ * - Cyan for symbolic links (with special handling to print the link target)
+ * - Green for executables
+ * - Default color for regular files
+ * 
+ * It also handles symbolic links, printing the link target and coloring the target 
+ * based on its type (directory, executable, etc.).
+ *
+ * @param path Path to the file or directory.
+ */
+void print_with_color(char *path) {
+    print_path_with_color(path, "   ");
+}
+
+/**
+ * @brief Prints file or directory names in columns with color based on their type.
+ *
+ * This function is similar to `print_with_color`, but it prints file or directory names in column format,
+ * with a new line after each name. The colors used are:
+ * - Blue for directories
+ * - Cyan for symbolic links (with the target printed after "->")
+ * - Green for executables
+ * - Default color for regular files
+ *
+ * It also prints symbolic links with the target and colors the target based on its type (directory, executable, etc.).
+ *
+ * @param path Path to the file or directory.
+ */
+void print_column_with_color(char *path) {
+    print_path_with_color(path, "\n");
+}
+
+/**
+ * @brief Appends a copy of a name to a path list.
+ *
+ * @param list List to append to.
+ * @param path Name to copy.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+int path_list_add(struct path_list *list, const char *path) {
+    char *copy;
+
+    if (list->count == list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : INITIAL_PATH_LIST_CAPACITY;
+        char **new_paths = realloc(list->paths, new_capacity * sizeof(char *));
+        if (new_paths == NULL) {
+            perror("realloc failed");
+            return -1;
+        }
+        list->paths = new_paths;
+        list->capacity = new_capacity;
+    }
+    copy = strdup(path);
+    if (copy == NULL) {
+        perror("strdup failed");
+        return -1;
+    }
+    list->paths[list->count++] = copy;
+    return 0;
+}
+
+/**
+ * @brief Releases a path list and the names it holds.
+ *
+ * @param list List to release; it is left empty and can be reused.
+ */
+void path_list_free(struct path_list *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * @brief Records a listed entry in the subdirectory sink if it is a directory.
+ *
+ * Used by `-R`: the directories are collected in the order the listing shows
+ * them, so the recursion visits them in that order. "." and ".." are never
+ * recorded and symbolic links are not followed.
+ *
+ * @param dir_fd Open directory containing the entry.
+ * @param name Name of the entry.
+ * @param d_type File type reported by the directory.
+ * @param entry Loaded metadata of the entry, or NULL if there is none.
+ */
+static void note_subdirectory(int dir_fd, const char *name, unsigned char d_type, const struct ls_entry *entry) {
+    struct stat info;       // Type of an entry the directory did not report
+
+    if (subdirectory_sink == NULL || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+        return;
+    }
+    if (entry != NULL && entry->is_loaded == 1) {
+        if (!S_ISDIR(entry->mode)) {
+            return;
+        }
+    } else if (d_type != DT_UNKNOWN) {
+        if (d_type != DT_DIR) {
+            return;
+        }
+    } else if (fstatat(dir_fd, name, &info, AT_SYMLINK_NOFOLLOW) == -1 || !S_ISDIR(info.st_mode)) {
+        return;
+    }
+    path_list_add(subdirectory_sink, name);
+}
+
+/**
+ * @brief Prints a directory entry's name in the color of its type.
+ *
+ * Directories and symbolic links are recognized from the `d_type` reported by
+ * the directory, so they never need a stat. Other entries are only stat'ed
+ * (once, lazily) because their executable bit decides the color. With `-f`
+ * no color is used and nothing is stat'ed, unless a long listing has to show
+ * where symbolic links point.
+ *
+ * @param dir_fd Open directory containing the entry.
+ * @param entry Entry to print; its metadata is loaded on demand.
+ * @param suffix Text printed after the name ("   " or a newline).
+ */
+static void print_entry_name(int dir_fd, struct ls_entry *entry, const char *suffix) {
+    mode_t mode;    // File type and permissions used to pick the color
+
+    if (is_no_sort_enabled == 1 && is_long_format_enabled == 0) {
+        print_colored(NULL, entry->name, suffix);  // No colors without sorting
+        return;
+    }
+
+    if (entry->is_loaded == 1) {
+        mode = entry->mode;
+    } else if (entry->d_type == DT_DIR) {
+        mode = S_IFDIR;
+    } else if (entry->d_type == DT_LNK) {
+        mode = S_IFLNK;
+    } else {
+        // The executable bit is only known after a stat
+        if (load_entry(dir_fd, entry->name, COLOR_STATX_MASK, entry) == -1) {
+            return;
+        }
+        mode = entry->mode;
+    }
+
+    if (S_ISLNK(mode) && is_long_format_enabled == 1) {
+        print_link_with_target(dir_fd, entry->name, entry->name, suffix);
+    } else if (is_no_sort_enabled == 1) {
+        print_colored(NULL, entry->name, suffix);  // No colors without sorting
+    } else if (S_ISDIR(mode)) {
+        print_colored(COLOR_DIRECTORY, entry->name, suffix);  // Blue for directories
+    } else if (S_ISLNK(mode)) {
+        print_colored(COLOR_LINK, entry->name, suffix);  // Cyan for symbolic links
+    } else if (mode & S_IXUSR) {
+        print_colored(COLOR_EXECUTABLE, entry->name, suffix);  // Green for executables
+    } else {
+        print_colored(NULL, entry->name, suffix);  // Default color for regular files
+    }
+}
+
+/**
+ * @brief Prints a directory entry's name in color (see `print_entry_name`) and
+ *        records it as a subdirectory for `-R` when it is one.
+ *
+ * @param dir_fd Open directory containing the entry.
+ * @param entry Entry to print; its metadata is loaded on demand.
+ * @param suffix Text printed after the name ("   " or a newline).
+ */
+static void print_entry_with_color(int dir_fd, struct ls_entry *entry, const char *suffix) {
+    note_subdirectory(dir_fd, entry->name, entry->d_type, entry);
+    print_entry_name(dir_fd, entry, suffix);
+}
+
+/**
+ * @brief Prints one cell of a column listing: the inode number if asked for, then the name.
+ *
+ * @param index Index of the entry.
+ * @param arg The entries being listed (struct column_listing).
+ */
+static void print_column_cell(size_t index, void *arg) {
+    struct column_listing *listing = arg;
+    struct ls_entry *entry = &listing->entries[index];
+
+    if (is_inode_enabled == 1) {
+        out_uint(out_current, entry->inode, 6);  // Print the inode number
+        out_putc(out_current, ' ');
+    }
+    print_entry_name(listing->dir_fd, entry, "");
+}
+
+/**
+ * @brief Prints sorted entries in as many columns as fit on the terminal.
+ *
+ * @param dir_fd Open directory containing the entries.
+ * @param entries Entries in listing order.
+ * @param count Number of entries.
+ */
+static void print_entries_in_columns(int dir_fd, struct ls_entry *entries, size_t count) {
+    struct column_listing listing = { dir_fd, entries };
+    uint16_t *widths;       // Display width of every cell
+    char digits[24];        // Inode number, to measure its width
+
+    // Subdirectories are recorded in listing order, not in the order the columns print them
+    for (size_t i = 0; i < count; i++) {
+        note_subdirectory(dir_fd, entries[i].name, entries[i].d_type, &entries[i]);
+    }
+
+    widths = malloc((count ? count : 1) * sizeof(uint16_t));
+    if (widths == NULL) {
+        perror("malloc failed");
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        widths[i] = text_display_width(entries[i].name);
+        if (is_inode_enabled == 1) {
+            int length = snprintf(digits, sizeof(digits), "%llu", (unsigned long long)entries[i].inode);
+            widths[i] += (length > 6 ? length : 6) + 1;
+        }
+    }
+    print_in_columns(widths, count, output_line_width, print_column_cell, &listing);
+    free(widths);
+}
+
+/**
+ * @brief Prints the entries of a directory in the order the directory returns them.
+ *
+ * Used for `-f`, where nothing is sorted or colored: every getdents64 batch is
+ * printed and flushed as soon as it arrives, so output starts immediately and
+ * memory stays at one batch however large the directory is.
+ *
+ * @param dir_fd Open directory to list.
+ * @param suffix Text printed after every name ("   " or a newline).
+ * @return int 0 on success, -1 if the directory could not be read.
+ */
+static int stream_directory_entries(int dir_fd, const char *suffix) {
+    struct dirent_reader reader;        // getdents64 reader over the directory
+    struct ls_dirent dirent;            // Current raw entry
+    char *buffer;                       // Buffer for the raw directory records
+    ssize_t bytes_read;                 // Result of the last batch read
+
+    buffer = malloc(dirent_buffer_size);
+    if (buffer == NULL) {
+        perror("malloc failed");
+        return -1;
+    }
+    dirent_reader_init(&reader, dir_fd, buffer, dirent_buffer_size);
+
+    while ((bytes_read = dirent_reader_fill(&reader)) > 0) {
+        while (dirent_reader_next(&reader, &dirent)) {
+            if (is_inode_enabled == 1) {
+                out_uint(out_current, dirent.inode, 6);  // The directory reports the inode number
+                out_putc(out_current, ' ');
+            }
+            out_write(out_current, dirent.name, dirent.name_length);
+            note_subdirectory(dir_fd, dirent.name, dirent.type, NULL);
+            out_puts(out_current, suffix);
+        }
+        out_flush(out_current);  // Hand the batch to the terminal before reading the next one
+    }
+
+    free(buffer);
+    return bytes_read == -1 ? -1 : 0;
+}
+
+/**
+ * @brief Orders two kept entries the way the selection drops them.
+ *
+ * @param selection The selection.
+ * @param a Slot of the first entry.
+ * @param b Slot of the second entry.
+ * @return int Positive if `a` would be dropped before `b`, negative if after.
+ */
+static int selection_compare(const struct top_selection *selection, size_t a, size_t b) {
+    return selection->direction * selection->compare(&selection->slots[a].entry, &selection->slots[b].entry);
+}
+
+/**
+ * @brief Restores the heap order by moving a heap element towards the root.
+ *
+ * @param selection The selection.
+ * @param position Heap position of the element.
+ */
+static void selection_sift_up(struct top_selection *selection, size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        size_t slot = selection->heap[position];
+
+        if (selection_compare(selection, slot, selection->heap[parent]) <= 0) {
+            break;
+        }
+        selection->heap[position] = selection->heap[parent];
+        selection->heap[parent] = slot;
+        position = parent;
+    }
+}
+
+/**
+ * @brief Restores the heap order by moving a heap element away from the root.
+ *
+ * @param selection The selection.
+ * @param position Heap position of the element.
+ */
+static void selection_sift_down(struct top_selection *selection, size_t position) {
+    for (;;) {
+        size_t largest = position;
+        size_t child = 2 * position + 1;
+        size_t slot;
+
+        if (child < selection->count && selection_compare(selection, selection->heap[child], selection->heap[largest]) > 0) {
+            largest = child;
+        }
+        child++;
+        if (child < selection->count && selection_compare(selection, selection->heap[child], selection->heap[largest]) > 0) {
+            largest = child;
+        }
+        if (largest == position) {
+            return;
+        }
+        slot = selection->heap[position];
+        selection->heap[position] = selection->heap[largest];
+        selection->heap[largest] = slot;
+        position = largest;
+    }
+}
+
+/**
+ * @brief Copies an entry into a slot of the selection, with its own copy of the name.
+ *
+ * @param selection The selection.
+ * @param slot Slot to fill.
+ * @param entry Entry to copy.
  */
-int compare(const void *a, const void *b) {
-    // Perform a simple lexicographical comparison of the two file names
-    return strcmp(*(const char **)a, *(const char **)b);
+static void selection_store(struct top_selection *selection, size_t slot, const struct ls_entry *entry) {
+    struct top_slot *target = &selection->slots[slot];
+
+    target->entry = *entry;
+    snprintf(target->name, sizeof(target->name), "%s", entry->name);
+    target->entry.name = target->name;
+    target->entry.sort_key = NULL;
 }
 
 /**
- * @brief Prints a file or directory name with appropriate colors based on its type.
+ * @brief Makes room for one more kept entry, doubling the slots up to the selection's capacity.
  *
- * This function prints file or directory names in color depending on their type:
- * - Blue for directories
- * - Cyan for symbolic links (with special handling to print the link target)
- * - Green for executables
- * - Default color for regular files
- * 
- * It also handles symbolic links, printing the link target and coloring the target 
- * based on its type (directory, executable, etc.).
+ * Slots are only allocated for entries actually kept, so a large N on a small
+ * directory costs nothing. Kept entries point at the names in their slots, so
+ * those pointers are rebased after the slots move.
  *
- * @param path Path to the file or directory.
+ * @param selection The selection; it must have fewer entries than its capacity.
+ * @return int 0 on success, -1 on overflow or allocation failure.
  */
-void print_with_color(char *path) {
-    struct stat file_info;        // Structure to hold information about the file/directory
-    struct stat target_info;      // Structure to hold information about the symlink target
-    char *file_name;              // Base name or full path of the file
-    char target_path[2048];        // Buffer to store the target of the symbolic link
-    ssize_t link_length;          // Length of the symbolic link target path
-    char dup_path[4096]  ; 
-    char resolved_path[2048] ; 
-    // Get the base name of the path (or the full path if necessary)
-    file_name = basename(path);
-    
-     // Attempt to resolve the path
-    if (realpath(path, resolved_path) == NULL) {
-        // If realpath fails, fall back to using lstat directly
-        snprintf(resolved_path, sizeof(resolved_path), "%s", path);
-    }
+static int selection_grow(struct top_selection *selection) {
+    size_t new_allocated;
+    struct top_slot *new_slots;
+    size_t *new_heap;
 
-    // Retrieve file or directory information using lstat
-    if (lstat(path, &file_info) == -1) {
-        perror("Failed to retrieve file information");
-        return; // Exit the function if an error occurs
+    if (selection->count < selection->allocated) {
+        return 0;
     }
+    new_allocated = selection->allocated ? selection->allocated * 2 : INITIAL_SELECTION_CAPACITY;
+    if (new_allocated < selection->allocated || new_allocated > selection->capacity) {
+        new_allocated = selection->capacity;
+    }
+    if (new_allocated > SIZE_MAX / sizeof(struct top_slot)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    new_slots = realloc(selection->slots, new_allocated * sizeof(struct top_slot));
+    if (new_slots == NULL) {
+        return -1;
+    }
+    selection->slots = new_slots;
+    for (size_t i = 0; i < selection->count; i++) {
+        selection->slots[i].entry.name = selection->slots[i].name;
+    }
+    new_heap = realloc(selection->heap, new_allocated * sizeof(size_t));
+    if (new_heap == NULL) {
+        return -1;
+    }
+    selection->heap = new_heap;
+    selection->allocated = new_allocated;
+    return 0;
+}
 
-    // If sorting is enabled, determine the type and print in corresponding color
-    if (is_no_sort_enabled == 0) {
-        if (S_ISDIR(file_info.st_mode)) {
-            printf("\033[34m%s\033[0m   ", file_name);  // Blue for directories
-        } else if (S_ISLNK(file_info.st_mode)) {
-            // Handle symbolic links
-            link_length = readlink(path, target_path, sizeof(target_path) - 1); // Get the target of the symlink
-            if (link_length != -1 && is_long_format_enabled == 1) {
-                target_path[link_length] = '\0'; // Null-terminate the target path
-                snprintf(dup_path, sizeof(dup_path), "%s/%s", resolved_path, target_path);
-                
-		// Retrieve the type of the symbolic link target
-                if (lstat(dup_path, &target_info) == -1) {
-                    // If target info cannot be retrieved, print the link without coloring the target
-                    printf("\033[36m%s\033[0m -> %s   ", file_name, target_path);  // Cyan for the symlink name
-                } else {
-                    // Print the target with color based on its type
-                    if (S_ISDIR(target_info.st_mode)) {
-                        printf("\033[36m%s\033[0m -> \033[34m%s\033[0m   ", file_name, target_path);  // Cyan for link, Blue for directory target
-                    } else if (target_info.st_mode & S_IXUSR) {
-                        printf("\033[36m%s\033[0m -> \033[32m%s\033[0m   ", file_name, target_path);  // Cyan for link, Green for executable target
-                    } else {
-                        printf("\033[36m%s\033[0m -> %s   ", file_name, target_path);  // Cyan for link, default for regular target
-                    }
-                }
-            } else {
-                printf("\033[36m%s\033[0m   ", file_name);  // Cyan for symlink if target retrieval fails
-            }
-        } else if (file_info.st_mode & S_IXUSR) {
-            printf("\033[32m%s\033[0m   ", file_name);  // Green for executables
-        } else {
-            printf("%s   ", file_name);  // Default color for regular files
-        }
-    } else {
-        // If no sorting is applied, just print the symlink with its target
-        link_length = readlink(path, target_path, sizeof(target_path) - 1); // Get the target of the symlink
-        if (link_length != -1 && is_long_format_enabled == 1) {
-            target_path[link_length] = '\0'; // Null-terminate the target path
-            printf("%s -> %s   ", file_name, target_path); // Print the symlink and its target
-        } else {
-            printf("%s   ", file_name);  // Print the file name if it's not a symlink
+/**
+ * @brief Offers an entry to the selection, keeping it if it ranks among the best so far.
+ *
+ * @param selection The selection.
+ * @param entry Loaded entry; it is copied, so it may be reused afterwards.
+ * @return int 0 on success, -1 if the selection could not grow.
+ */
+static int selection_offer(struct top_selection *selection, const struct ls_entry *entry) {
+    if (selection->count < selection->capacity) {
+        if (selection_grow(selection) == -1) {
+            return -1;
         }
+        selection_store(selection, selection->count, entry);
+        selection->heap[selection->count] = selection->count;
+        selection->count++;
+        selection_sift_up(selection, selection->count - 1);
+    } else if (selection->direction * selection->compare(entry, &selection->slots[selection->heap[0]].entry) < 0) {
+        // Replace the entry that would be dropped first
+        selection_store(selection, selection->heap[0], entry);
+        selection_sift_down(selection, 0);
     }
+    return 0;
 }
 
 /**
- * @brief Prints file or directory names in columns with color based on their type.
+ * @brief Lists only the newest (`--top`) or oldest (`--bottom`) entries of a directory.
  *
- * This function is similar to `print_with_color`, but it prints file or directory names in column format,
- * with a new line after each name. The colors used are:
- * - Blue for directories
- * - Cyan for symbolic links (with the target printed after "->")
- * - Green for executables
- * - Default color for regular files
- *
- * It also prints symbolic links with the target and colors the target based on its type (directory, executable, etc.).
+ * The directory is read one getdents64 batch at a time; every batch is stat'ed
+ * like a whole table would be and each entry is offered to a bounded heap of
+ * the N entries that rank best. Memory stays at one batch plus N entries and
+ * the work is O(n log N) instead of a full sort. The kept entries are printed
+ * in the order `-t` (or `-c`) would list them, so `--top=N` prints what
+ * `myls -t | head -N` would and `--bottom=N` what `tail -N` would. In long
+ * format the total still covers every entry of the directory.
  *
- * @param path Path to the file or directory.
+ * @param dir_fd Open directory to list; it stays open.
  */
-void print_column_with_color(char *path) {
-    struct stat file_info;        // Structure to hold file or directory information
-    struct stat target_info;      // Structure to hold information about the symbolic link target
-    char *file_name;              // Base name or full path of the file
-    char target_path[256];        // Buffer to store the target of the symbolic link
-    ssize_t link_length;          // Length of the symbolic link target
-
-    // Get the base name of the path (or the full path if necessary)
-    file_name = basename(path);
-
-    // Retrieve file or directory information using lstat
-    if (lstat(path, &file_info) == -1) {
-        perror("Failed to retrieve file information");
-        return; // Exit the function if an error occurs
+static void list_top_entries(int dir_fd) {
+    struct top_selection selection;     // Best entries seen so far
+    struct ls_entry_table batch;        // Entries of the current getdents64 batch
+    struct dirent_reader reader;        // getdents64 reader over the directory
+    struct ls_dirent dirent;            // Current raw entry
+    struct ls_entry *sorted;            // Kept entries in listing order
+    struct long_widths widths;          // Column widths of the long listing
+    char *buffer;                       // Buffer for the raw directory records
+    unsigned long long total_blocks = 0;    // 512-byte blocks allocated to all entries
+    int status = 0;                     // -1 once the selection could not grow
+
+    selection.slots = NULL;
+    selection.heap = NULL;
+    selection.allocated = 0;
+    selection.capacity = top_entry_count;
+    selection.count = 0;
+    selection.direction = is_bottom_enabled == 1 ? -1 : 1;
+    // -c orders by change time unless -t asked for modification time
+    selection.compare = (is_ctime_option_enabled == 1 && is_sort_by_time_enabled == 0 && is_sort_by_access_time_enabled == 0)
+                        ? compare_by_ctime : compare_by_access_time;
+    buffer = malloc(dirent_buffer_size);
+    if (buffer == NULL) {
+        perror("malloc failed");
+        return;
     }
 
-    // If sorting is enabled, determine the type and print in corresponding color
-    if (is_no_sort_enabled == 0) {
-        // Check if it's a directory
-        if (S_ISDIR(file_info.st_mode)) {
-            printf("\033[34m%s\033[0m\n", file_name);  // Blue for directories
-        }
-        // Check if it's a symbolic link
-        else if (S_ISLNK(file_info.st_mode)) {
-            // Get the target of the symbolic link
-            link_length = readlink(path, target_path, sizeof(target_path) - 1);
-            if (link_length != -1 && is_long_format_enabled == 1) {
-                target_path[link_length] = '\0'; // Null-terminate the target path
-
-                // Retrieve the type of the symbolic link target
-                if (lstat(target_path, &target_info) == -1) {
-                    // If target info cannot be retrieved, print the link without coloring the target
-                    printf("\033[36m%s\033[0m -> %s\n", file_name, target_path);  // Cyan for the symlink name
-                } else {
-                    // Print the target with color based on its type
-                    if (S_ISDIR(target_info.st_mode)) {
-                        printf("\033[36m%s\033[0m -> \033[34m%s\033[0m\n", file_name, target_path);  // Cyan for link, Blue for directory target
-                    } else if (target_info.st_mode & S_IXUSR) {
-                        printf("\033[36m%s\033[0m -> \033[32m%s\033[0m\n", file_name, target_path);  // Cyan for link, Green for executable target
-                    } else {
-                        printf("\033[36m%s\033[0m -> %s\n", file_name, target_path);  // Cyan for link, default for regular target
-                    }
-                }
-            } else {
-                // Just print the name if the target of the symbolic link cannot be retrieved
-                printf("\033[36m%s\033[0m\n", file_name);  // Cyan for symbolic links
+    entry_table_init(&batch);
+    batch.dir_fd = dir_fd;
+    dirent_reader_init(&reader, dir_fd, buffer, dirent_buffer_size);
+    while (status == 0 && dirent_reader_fill(&reader) > 0) {
+        // Reuse the batch table's memory for every batch
+        batch.count = 0;
+        batch.names_used = 0;
+        while (dirent_reader_next(&reader, &dirent)) {
+            if (dirent.name[0] == '.' && is_hidden_files_enabled == 0 && is_no_sort_enabled == 0) {
+                continue;
             }
+            struct ls_entry *entry = entry_table_add(&batch, dirent.name, dirent.name_length);
+            if (entry == NULL) {
+                break;
+            }
+            entry->d_type = dirent.type;
+            entry->inode = dirent.inode;
         }
-        // Check if it's an executable file
-        else if (file_info.st_mode & S_IXUSR) {
-            printf("\033[32m%s\033[0m\n", file_name);  // Green for executables
-        }
-        // For regular files
-        else {
-            printf("%s\n", file_name);  // Default color for regular files
+        load_table_metadata(&batch);
+        for (size_t i = 0; i < batch.count && status == 0; i++) {
+            total_blocks += batch.entries[i].blocks;
+            status = selection_offer(&selection, &batch.entries[i]);
         }
     }
-    // If sorting is disabled, just print the symbolic link and its target
-    else {
-        // Get the target of the symbolic link
-        link_length = readlink(path, target_path, sizeof(target_path) - 1);
-        if (link_length != -1 && is_long_format_enabled == 1) {
-            target_path[link_length] = '\0';  // Null-terminate the target path
-            printf("%s -> %s\n", file_name, target_path);  // Print the symbolic link and its target
-        } else {
-            // Print the file name if it's not a symbolic link
-            printf("%s\n", file_name);
+    batch.dir_fd = -1;      // The caller owns the directory
+    entry_table_free(&batch);
+    free(buffer);
+    if (status == -1) {
+        perror("malloc failed");
+        free(selection.slots);
+        free(selection.heap);
+        return;
+    }
+
+    // Put the kept entries in listing order
+    sorted = malloc((selection.count ? selection.count : 1) * sizeof(struct ls_entry));
+    if (sorted == NULL) {
+        perror("malloc failed");
+        free(selection.slots);
+        free(selection.heap);
+        return;
+    }
+    for (size_t i = 0; i < selection.count; i++) {
+        sorted[i] = selection.slots[i].entry;
+    }
+    qsort(sorted, selection.count, sizeof(struct ls_entry), selection.compare);
+
+    if (is_long_format_enabled == 1) {
+        out_puts(out_current, "total ");
+        out_uint(out_current, (total_blocks + 1) / 2, 0);  // In 1 KiB blocks, rounded up
+        out_putc(out_current, '\n');
+    }
+    if (is_long_format_enabled == 1) {
+        measure_long_widths(sorted, selection.count, &widths);
+        for (size_t i = 0; i < selection.count; i++) {
+            if (is_inode_enabled == 1) {
+                out_uint(out_current, sorted[i].inode, widths.inode);  // Print the inode number
+                out_putc(out_current, ' ');
+            }
+            print_entry_longformat(dir_fd, &sorted[i], &widths);
+        }
+    } else if (is_column_output_enabled == 0) {
+        print_entries_in_columns(dir_fd, sorted, selection.count);
+    } else {
+        for (size_t i = 0; i < selection.count; i++) {
+            if (is_inode_enabled == 1) {
+                out_uint(out_current, sorted[i].inode, 6);  // Print the inode number
+                out_putc(out_current, ' ');
+            }
+            print_entry_with_color(dir_fd, &sorted[i], "\n");
         }
     }
+
+    free(sorted);
+    free(selection.slots);
+    free(selection.heap);
 }
 
 /**
@@ -364,22 +1620,21 @@ void print_column_with_color(char *path) {
  * - Displaying file inodes if enabled.
  * - Colorized output based on file types (directories, symbolic links, executables, etc.).
  *
+ * @param base_fd Directory `input_path` is relative to, or AT_FDCWD.
  * @param input_path Path to the directory or file to list.
  */
-void do_ls(char *input_path) {
-    struct dirent *directory_entry;        // Pointer for directory entries
+void do_ls_at(int base_fd, char *input_path) {
     struct stat file_stat;                 // Structure to hold file or directory stats
     uint8_t is_file = 0;                   // Flag to check if the input is a file
-    DIR *directory_ptr = opendir(input_path); // Open the directory
-    char full_path[1024];                  // Buffer to store the full path for each entry
-    char *file_entries[MAX_ENTRIES];       // Array to store the names of files in the directory
-    int entry_count = 0;                   // Counter for the number of entries
+    int dir_fd = openat(base_fd, input_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC); // Open the directory
+    struct ls_entry_table table;           // Entries of the directory
+    struct ls_entry *entry;                // Entry being read or printed
 
 
     // Check if the directory can be opened
-    if (directory_ptr == NULL) {
+    if (dir_fd == -1) {
         // If the directory can't be opened, check if it's a regular file
-        if (lstat(input_path, &file_stat) == -1) {
+        if (fstatat(base_fd, input_path, &file_stat, AT_SYMLINK_NOFOLLOW) == -1) {
             perror("stat failed");
             return;
         }
@@ -391,59 +1646,62 @@ void do_ls(char *input_path) {
         is_file = 1;  // Set the flag if it's a regular file
     }
 
+    // Only the newest (or oldest) entries are kept while reading
+    if (is_file == 0 && top_entry_count > 0) {
+        list_top_entries(dir_fd);
+        close(dir_fd);
+    }
+    // Without sorting, entries are printed straight from the directory as they are read
+    else if (is_file == 0 && is_no_sort_enabled == 1) {
+        stream_directory_entries(dir_fd, is_column_output_enabled == 1 ? "\n" : "   ");
+        close(dir_fd);
+    }
     // If input is a directory, proceed to read its entries
-    if (is_file == 0) {
+    else if (is_file == 0) {
+        entry_table_init(&table);
+        table.dir_fd = dir_fd;  // The table keeps the directory open until it is freed
+
         // Read directory entries
-        while ((directory_entry = readdir(directory_ptr)) != NULL) {
-            // Skip hidden files if the hiddenfiles_flag is not set
-            if (directory_entry->d_name[0] == '.' && is_hidden_files_enabled == 0 && is_no_sort_enabled == 0) {
-                continue;
-            }
-            // Store the name of the entry in the file_entries array
-            file_entries[entry_count++] = strdup(directory_entry->d_name);
+        read_directory_entries(&table);
+
+        // Time sorts need every entry's metadata up front; otherwise it is loaded only when printing needs it
+        if ((is_sort_by_time_enabled == 1 || is_sort_by_access_time_enabled == 1 || is_ctime_option_enabled == 1) && is_no_sort_enabled == 0) {
+            load_table_metadata(&table);
         }
-        closedir(directory_ptr);  // Close the directory after reading entries
 
         // Sort the entries based on the specified sort options
         if ((is_sort_by_time_enabled == 1 || is_sort_by_access_time_enabled == 1) && is_no_sort_enabled == 0) {
-            qsort(file_entries, entry_count, sizeof(char *), compare_by_access_time);
+            sort_entries_by_time(&table, 0);
         } else if (is_ctime_option_enabled == 1 && is_no_sort_enabled == 0) {
-            qsort(file_entries, entry_count, sizeof(char *), compare_by_ctime);
-        } else if (is_no_sort_enabled == 0 ) {
-            qsort(file_entries, entry_count, sizeof(char *), compare_case_insensitive);
-        }
-
-        // Print the sorted entries
-        for (int i = 0; i < entry_count; i++) {
-            // Build the full path for each entry
-            if (strcmp(input_path, "/") == 0) {
-                snprintf(full_path, sizeof(full_path), "%s%s", input_path, file_entries[i]);
-            } else {
-                snprintf(full_path, sizeof(full_path), "%s/%s", input_path, file_entries[i]);
-            }
+            sort_entries_by_time(&table, 1);
+        } else if (is_no_sort_enabled == 0) {
+            sort_entries_by_name(&table);
+        }
 
-            // Print inode if the inode_flag is set
-            if (is_inode_enabled == 1) {
-                if (lstat(full_path, &file_stat) != -1) {
-                    printf("%6ld ", file_stat.st_ino);  // Print the inode number
-                }
-            }
+        // Print the sorted entries, one per line or in as many columns as fit
+        if (is_column_output_enabled == 0) {
+            print_entries_in_columns(dir_fd, table.entries, table.count);
+        } else {
+            for (size_t i = 0; i < table.count; i++) {
+                entry = &table.entries[i];
 
-            // Print the entry with or without column format based on column_flag
-            if (is_column_output_enabled == 1) {
-                print_column_with_color(full_path);  // Print in column format with color
-            } else {
-                print_with_color(full_path);  // Print in standard format with color
+                // Print inode if the inode_flag is set (the directory already reported it)
+                if (is_inode_enabled == 1) {
+                    out_uint(out_current, entry->inode, 6);  // Print the inode number
+                    out_putc(out_current, ' ');
+                }
+                print_entry_with_color(dir_fd, entry, "\n");  // Print in column format with color
             }
-            free(file_entries[i]);  // Free the allocated memory for the entry name
         }
+        entry_table_free(&table);
     } 
     // If the input was a regular file, handle the file directly
     else {
         // Print inode if the inode_flag is set
         if (is_inode_enabled == 1) {
-            if (lstat(input_path, &file_stat) != -1) {
-                printf("%6ld ", file_stat.st_ino);  // Print the inode number
+            if (fstatat(base_fd, input_path, &file_stat, AT_SYMLINK_NOFOLLOW) != -1) {
+                    out_uint(out_current, file_stat.st_ino, 6);  // Print the inode number
+                    out_putc(out_current, ' ');
             }
         }
 
@@ -455,155 +1713,361 @@ void do_ls(char *input_path) {
         }
     }
 
-    // Add a newline if not printing in column format
-    if (is_column_output_enabled == 0) {
-        printf("\n");  // New line after listing
+    // End the line of a file or an unsorted listing; column layouts end every row themselves
+    if (is_column_output_enabled == 0 && (is_file == 1 || (is_no_sort_enabled == 1 && top_entry_count == 0))) {
+        out_putc(out_current, '\n');  // New line after listing
     }
 }
+/**
+ * @brief Lists files in the specified directory (see `do_ls_at`), relative to the working directory.
+ *
+ * @param input_path Path to the directory or file to list.
+ */
+void do_ls(char *input_path) {
+    do_ls_at(AT_FDCWD, input_path);
+}
+
+static void print_path_longformat(char *path, const struct ls_entry *entry, const struct long_widths *widths);
+
 /**
  * @brief Lists the contents of a directory in long format, including details like permissions, owner, size, and modification time.
  *
  * This function lists files and directories within the specified `input_path`, providing detailed information for each entry.
  * It also supports sorting by time, showing hidden files, displaying inode numbers, and summing file sizes.
  *
+ * @param base_fd Directory `input_path` is relative to, or AT_FDCWD.
  * @param input_path Path to the directory or file to list.
  */
-void list_directory_long_format(char *input_path) {
-    DIR *directory_ptr = opendir(input_path);  // Open the directory
-    struct dirent *directory_entry;            // Structure to hold directory entries
-    struct stat file_stat;                     // Structure to hold file statistics
-    char full_path[1024];                      // Buffer to store the full path for each file
-    long total_size = 0;                       // Total size of files in the directory (in bytes)
+void list_directory_long_format_at(int base_fd, char *input_path) {
+    int dir_fd = openat(base_fd, input_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);  // Open the directory
+    struct ls_entry file_entry;                // Metadata of the input when it is a file
+    unsigned long long total_blocks = 0;       // 512-byte blocks allocated to the directory's entries
     char is_file = 0;                          // Flag to check if the input is a file
+    struct link_directory previous_directory = listing_directory;  // Restored once this listing is done
 
     // Check if the directory can be opened
-    if (directory_ptr == NULL) {
-        // If it's not a directory, check if it's a regular file
-        if (lstat(input_path, &file_stat) == -1) {
-            perror("stat failed");
+    if (dir_fd == -1) {
+        // If it's not a directory, fetch everything its row shows at once and check it is a regular file
+        memset(&file_entry, 0, sizeof(file_entry));
+        if (load_entry(base_fd, input_path, listing_statx_mask(), &file_entry) == -1) {
             return;
         }
         // If not a regular file, print an error
-        if (!S_ISREG(file_stat.st_mode)) {
+        if (!S_ISREG(file_entry.mode)) {
             fprintf(stderr, "Cannot open directory: %s\n", input_path);
             return;
         }
         is_file = 1;  // Set the flag indicating the input is a file
     }
 
-    // Array to hold filenames, assuming a max of 1024 entries
-    char *filenames[1024];
-    int total_count = 0;
-
-    // If it's a directory, read and process its contents
-    if (is_file == 0) {
-        // First pass: Read entries and store filenames
-        while ((directory_entry = readdir(directory_ptr)) != NULL) {
-            // Construct the full path for each entry
-            if (strcmp(input_path, "/") == 0) {
-                snprintf(full_path, sizeof(full_path), "%s%s", input_path, directory_entry->d_name);
-            } else {
-                snprintf(full_path, sizeof(full_path), "%s/%s", input_path, directory_entry->d_name);
-            }
-
-            // Skip hidden files if the hiddenfiles_flag is not set
-            if (directory_entry->d_name[0] == '.' && is_hidden_files_enabled == 0 && is_no_sort_enabled == 0) {
-                continue;
-            }
+    // Entries of the directory, grown as needed
+    struct ls_entry_table table;
+    struct ls_entry *entry;
+    struct long_widths widths;                 // Column widths, measured before the first row is printed
 
-            // Store the filename and increment the total count
-            filenames[total_count++] = strdup(directory_entry->d_name);
+    // Links in this directory key their targets by its identity, fetched at most once
+    listing_directory.fd = dir_fd;
+    listing_directory.is_known = 0;
 
-            // Get file statistics and add the size to total_size
-            if (stat(full_path, &file_stat) == 0) {
-                total_size += file_stat.st_size;  // Add the file size to the total size
-            } else {
-                perror("stat failed");
-                return;
-            }
+    // Only the newest (or oldest) entries are kept while reading
+    if (is_file == 0 && top_entry_count > 0) {
+        list_top_entries(dir_fd);
+        close(dir_fd);
+    }
+    // If it's a directory, read and process its contents
+    else if (is_file == 0) {
+        entry_table_init(&table);
+        table.dir_fd = dir_fd;  // The table keeps the directory open until it is freed
+
+        // First pass: Read entries and gather their metadata once, relative to the open directory
+        read_directory_entries(&table);
+        load_table_metadata(&table);
+        for (size_t i = 0; i < table.count; i++) {
+            total_blocks += table.entries[i].blocks;  // Add the entry's allocated blocks to the total
         }
+        measure_long_widths(table.entries, table.count, &widths);  // Size every column to its widest value
 
-        // Close the directory after reading its contents
-        closedir(directory_ptr);
-
-        // Sort the filenames based on flags and options
+        // Sort the entries based on flags and options
         if (is_hidden_files_enabled == 1 && is_sort_by_time_enabled == 0 && is_no_sort_enabled == 0) {
-            qsort(filenames, total_count, sizeof(char *), compare_with_hidden);
+            qsort(table.entries, table.count, sizeof(struct ls_entry), compare_with_hidden);
         } else if (is_sort_by_time_enabled == 1 && is_no_sort_enabled == 0) {
-            qsort(filenames, total_count, sizeof(char *), compare_by_access_time);
+            sort_entries_by_time(&table, 0);
         } else if (is_no_sort_enabled == 0) {
-            qsort(filenames, total_count, sizeof(char *), compare_case_insensitive);
+            sort_entries_by_name(&table);
         }
 
-        // Print total size in kilobytes (total_size is in bytes)
-        printf("total %ld\n", total_size / 1024);
+        // Print the space allocated to the entries in kilobytes, like ls does
+        out_puts(out_current, "total ");
+        out_uint(out_current, (total_blocks + 1) / 2, 0);  // In 1 KiB blocks, rounded up
+        out_putc(out_current, '\n');
 
         // Second pass: Display detailed information for each entry
-        for (int i = 0; i < total_count; i++) {
-            // Construct the full path for each entry
-            snprintf(full_path, sizeof(full_path), "%s/%s", input_path, filenames[i]);
+        for (size_t i = 0; i < table.count; i++) {
+            entry = &table.entries[i];
 
             // Print inode number if inode_flag is set
             if (is_inode_enabled == 1) {
-                if (lstat(full_path, &file_stat) != -1) {
-                    printf("%6ld ", file_stat.st_ino);  // Print inode number
-                }
+                out_uint(out_current, entry->inode, widths.inode);  // Print inode number
+                out_putc(out_current, ' ');
             }
 
-            // Print the file's detailed information in long format
-            print_longformat(full_path);
-            free(filenames[i]);  // Free the allocated memory for the filename
+            // Print the entry's detailed information in long format
+            print_entry_longformat(dir_fd, entry, &widths);
         }
+        entry_table_free(&table);
     } 
-    // If the input is a file, process it directly
+    // If the input is a file, print its row from the metadata fetched above
     else {
-        // Print inode number if inode_flag is set
-        if (is_inode_enabled == 1) {
-            if (lstat(input_path, &file_stat) != -1) {
-                printf("%6ld ", file_stat.st_ino);  // Print inode number
+        measure_long_widths(&file_entry, 1, &widths);
+        print_path_longformat(input_path, &file_entry, &widths);
+    }
+    listing_directory = previous_directory;
+}
+
+/**
+ * @brief Lists a directory in long format (see `list_directory_long_format_at`), relative to the working directory.
+ *
+ * @param input_path Path to the directory or file to list.
+ */
+void list_directory_long_format(char *input_path) {
+    list_directory_long_format_at(AT_FDCWD, input_path);
+}
+
+/**
+ * @brief Finds the slot of an ID in a name cache. The cache lock must be held.
+ *
+ * @param cache Cache to search; it must have at least one free slot.
+ * @param id User or group ID.
+ * @return struct id_name* The slot holding the ID, or the free slot where it belongs.
+ */
+static struct id_name *id_cache_slot(struct id_cache *cache, unsigned int id) {
+    size_t index = (id * 2654435761u) & (cache->capacity - 1);  // Multiplicative hash
+
+    while (cache->slots[index].name != NULL && cache->slots[index].id != id) {
+        index = (index + 1) & (cache->capacity - 1);
+    }
+    return &cache->slots[index];
+}
+
+/**
+ * @brief Doubles the number of slots of a name cache. The cache lock must be held.
+ *
+ * @param cache Cache to grow.
+ * @return int 0 on success, -1 if memory ran out.
+ */
+static int id_cache_grow(struct id_cache *cache) {
+    struct id_name *old_slots = cache->slots;
+    size_t old_capacity = cache->capacity;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : INITIAL_ID_CACHE_CAPACITY;
+    struct id_name *new_slots = calloc(new_capacity, sizeof(struct id_name));
+
+    if (new_slots == NULL) {
+        return -1;
+    }
+    cache->slots = new_slots;
+    cache->capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].name != NULL) {
+            *id_cache_slot(cache, old_slots[i].id) = old_slots[i];
+        }
+    }
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * @brief Returns the user or group name of an ID, asking NSS only the first time.
+ *
+ * IDs without a name are cached too (negative caching) and are shown as the
+ * number itself, the way ls does, instead of abandoning the row.
+ *
+ * @param cache Cache of user names or of group names.
+ * @param id User or group ID.
+ * @param is_group 1 to resolve a group name, 0 for a user name.
+ * @param length Receives the length of the name (may be NULL).
+ * @return const char* The name; it stays valid for the rest of the run.
+ */
+static const char *cached_id_name(struct id_cache *cache, unsigned int id, int is_group, size_t *length) {
+    static __thread char fallback[16];  // Used only if the cache cannot allocate
+    struct id_name *slot;
+    const char *resolved = NULL;
+    char number[16];
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->capacity == 0 || (cache->count + 1) * 2 > cache->capacity) {
+        if (id_cache_grow(cache) == -1 && cache->capacity == cache->count) {
+            pthread_mutex_unlock(&cache->lock);
+            snprintf(fallback, sizeof(fallback), "%u", id);
+            if (length != NULL) {
+                *length = strlen(fallback);
+            }
+            return fallback;
+        }
+    }
+    slot = id_cache_slot(cache, id);
+    if (slot->name == NULL) {
+        if (is_group) {
+            struct group *grp = getgrgid((gid_t)id);
+            resolved = grp ? grp->gr_name : NULL;
+        } else {
+            struct passwd *owner_info = getpwuid((uid_t)id);
+            resolved = owner_info ? owner_info->pw_name : NULL;
+        }
+        if (resolved == NULL) {
+            snprintf(number, sizeof(number), "%u", id);  // Unknown IDs are shown numerically
+            resolved = number;
+        }
+        slot->name = strdup(resolved);
+        if (slot->name == NULL) {
+            pthread_mutex_unlock(&cache->lock);
+            snprintf(fallback, sizeof(fallback), "%s", resolved);
+            if (length != NULL) {
+                *length = strlen(fallback);
             }
+            return fallback;
         }
+        slot->id = id;
+        slot->length = strlen(slot->name);
+        cache->count++;
+    }
+    resolved = slot->name;
+    if (length != NULL) {
+        *length = slot->length;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return resolved;
+}
 
-        // Print the file's detailed information in long format
-        print_longformat(input_path);
+/**
+ * @brief Formats a modification time, converting each distinct minute only once.
+ *
+ * Files in a directory tend to share a handful of minutes, so most calls are a
+ * direct-mapped cache hit and skip both the timezone conversion and strftime.
+ * The locale is set once at startup, never here.
+ *
+ * @param seconds Modification time in seconds since the epoch.
+ * @return const char* The formatted time (valid until the slot is reused), or NULL on error.
+ */
+static const char *format_modification_time(time_t seconds) {
+    time_t minute = seconds / 60 - (seconds % 60 < 0);     // Round down, also before 1970
+    struct time_cache_slot *slot = &time_cache[(size_t)minute % TIME_CACHE_SLOTS];
+    struct tm modification_time;        // Broken-down local time
+
+    if (slot->is_used == 1 && slot->minute == minute) {
+        return slot->text;
+    }
+
+    // Get the local time of the modification
+    if (localtime_r(&seconds, &modification_time) == NULL) {
+        perror("localtime failed");
+        return NULL;
+    }
+    // Format the time to include day, date, month, and time
+    if (strftime(slot->text, sizeof(slot->text), "%H:%M %d %b", &modification_time) == 0) {
+        fprintf(stderr, "Error formatting the time\n");
+        return NULL;
     }
+    slot->minute = minute;
+    slot->is_used = 1;
+    return slot->text;
 }
 
 /**
- * @brief Prints the detailed information of a file or directory in long format.
+ * @brief Returns the number of decimal digits of a number.
+ *
+ * @param value Number to measure.
+ * @return size_t Number of digits (1 for 0).
+ */
+static size_t decimal_width(unsigned long long value) {
+    size_t width = 1;
+
+    while (value >= 10) {
+        value /= 10;
+        width++;
+    }
+    return width;
+}
+
+/**
+ * @brief Measures the long format columns over every row of a listing.
  *
- * This function retrieves file statistics and displays the file type, permissions, owner,
- * group, size, last modification time, and the name of the file or directory.
+ * Runs over the metadata already gathered for the rows, so it costs no system
+ * call; owner and group names come from the name caches with their lengths,
+ * and runs of rows with the same owner or group look the name up only once.
+ * Columns never get narrower than the fixed widths used for a single file.
  *
- * @param path Path to the file or directory to be printed.
+ * @param entries Loaded metadata of the rows.
+ * @param count Number of rows.
+ * @param widths Receives the width of every column.
  */
-void print_longformat(char *path) {
-    struct stat buf;                       // Structure to hold file statistics
+void measure_long_widths(const struct ls_entry *entries, size_t count, struct long_widths *widths) {
+    size_t length;                      // Length of an owner or group name
+    uid_t last_uid = 0;                 // Owner of the previous row
+    gid_t last_gid = 0;                 // Group of the previous row
+
+    widths->inode = MIN_INODE_WIDTH;
+    widths->nlink = MIN_NLINK_WIDTH;
+    widths->owner = MIN_NAME_WIDTH;
+    widths->group = MIN_NAME_WIDTH;
+    widths->size = MIN_SIZE_WIDTH;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct ls_entry *entry = &entries[i];
+
+        if (is_inode_enabled == 1 && decimal_width(entry->inode) > widths->inode) {
+            widths->inode = decimal_width(entry->inode);
+        }
+        if (decimal_width(entry->nlink) > widths->nlink) {
+            widths->nlink = decimal_width(entry->nlink);
+        }
+        if (decimal_width((unsigned long long)entry->size) > widths->size) {
+            widths->size = decimal_width((unsigned long long)entry->size);
+        }
+        if (i == 0 || entry->uid != last_uid) {
+            cached_id_name(&user_name_cache, entry->uid, 0, &length);
+            if (length > widths->owner) {
+                widths->owner = length;
+            }
+            last_uid = entry->uid;
+        }
+        if (i == 0 || entry->gid != last_gid) {
+            cached_id_name(&group_name_cache, entry->gid, 1, &length);
+            if (length > widths->group) {
+                widths->group = length;
+            }
+            last_gid = entry->gid;
+        }
+    }
+}
+
+/**
+ * @brief Prints the long format columns of an entry, up to (but not including) its name.
+ *
+ * This function displays the file type, permissions, owner, group, size and last
+ * modification time of the entry from its preloaded metadata.
+ *
+ * @param entry Preloaded metadata of the entry.
+ * @param widths Widths of the columns (see `measure_long_widths`).
+ * @return int 0 if the columns were printed, -1 if the row has to be abandoned.
+ */
+static int print_long_fields(const struct ls_entry *entry, const struct long_widths *widths) {
     char permissions[10];                  // Buffer for file permissions string
     int mode;                              // Variable to store file mode
-    uid_t ownerID;                         // Variable for storing the owner ID
-    struct passwd *ownerInfo;              // Structure for user information
-    struct group *grp;                     // Structure for group information
-    struct tm *modification_time;          // Structure to hold modification time
-    char time_str[100];                    // Buffer to store formatted time string
-
-    // Retrieve file stats
-    if (lstat(path, &buf) == -1) {
-        perror("lstat failed");
-        return;
-    }
+    const char *owner_name;                // Owner's name (or numeric ID)
+    const char *group_name;                // Group's name (or numeric ID)
+    const char *time_str;                  // Formatted modification time
 
-    mode = buf.st_mode;
+    mode = entry->mode;
 
     // Determine file type and print the corresponding character
-    if (S_ISREG(mode)) printf("-");
-    else if (S_ISDIR(mode)) printf("d");
-    else if (S_ISBLK(mode)) printf("b");
-    else if (S_ISCHR(mode)) printf("c");
-    else if (S_ISLNK(mode)) printf("l");
-    else if (S_ISFIFO(mode)) printf("p");
-    else if (S_ISSOCK(mode)) printf("s");
-    else printf("Unknown type");
+    if (S_ISREG(mode)) out_putc(out_current, '-');
+    else if (S_ISDIR(mode)) out_putc(out_current, 'd');
+    else if (S_ISBLK(mode)) out_putc(out_current, 'b');
+    else if (S_ISCHR(mode)) out_putc(out_current, 'c');
+    else if (S_ISLNK(mode)) out_putc(out_current, 'l');
+    else if (S_ISFIFO(mode)) out_putc(out_current, 'p');
+    else if (S_ISSOCK(mode)) out_putc(out_current, 's');
+    else out_puts(out_current, "Unknown type");
 
     // Construct permission string
     strcpy(permissions, "---------");
@@ -624,46 +2088,118 @@ void print_longformat(char *path) {
     if (mode & S_IXOTH) permissions[8] = (mode & S_ISVTX) ? 't' : 'x'; // Others execute or sticky bit
 
     // Get Owner and Group information
-    ownerID = buf.st_uid;
-    ownerInfo = getpwuid(ownerID);
-    grp = getgrgid(buf.st_gid);
-    if (ownerInfo == NULL) {
-        perror("getpwuid failed");
-        return;
-    }
-    if (grp == NULL) {
-        perror("getgrgid failed");
-        return;
-    }
+    owner_name = cached_id_name(&user_name_cache, entry->uid, 0, NULL);
+    group_name = cached_id_name(&group_name_cache, entry->gid, 1, NULL);
 
     // Get the last modification time
-    modification_time = localtime(&buf.st_mtime);
-    if (modification_time == NULL) {
-	    perror("localtime failed");
-	    return;
+    time_str = format_modification_time(entry->mtime.tv_sec);
+    if (time_str == NULL) {
+        return -1;
     }
 
-    // Set locale for Arabic (or any desired locale)
-    if (!setlocale(LC_TIME, "ar_AE.UTF-8")) {
-	    setlocale(LC_TIME, "C"); // Default to English if Arabic locale is not available
+    // Print file permissions, number of hard links, owner, group, size and modification time
+    out_write(out_current, permissions, 9);        // Print permission string
+    out_putc(out_current, ' ');
+    out_uint(out_current, entry->nlink, widths->nlink);    // Print number of hard links
+    out_putc(out_current, ' ');
+    out_padded(out_current, owner_name, widths->owner);    // Print owner's name
+    out_putc(out_current, ' ');
+    out_padded(out_current, group_name, widths->group);    // Print group's name
+    out_putc(out_current, ' ');
+    out_uint(out_current, entry->size, widths->size);      // Print file size
+    out_putc(out_current, ' ');
+    out_padded(out_current, time_str, 5);          // Print formatted modification time
+    out_putc(out_current, ' ');
+    return 0;
+}
+
+/**
+ * @brief Prints the long format row of a path from its preloaded metadata.
+ *
+ * @param path Path of the file or directory, used for its name.
+ * @param entry Preloaded metadata of the path.
+ * @param widths Widths of the columns, measured over every row being printed.
+ */
+static void print_path_longformat(char *path, const struct ls_entry *entry, const struct long_widths *widths) {
+    // Print inode number if inode_flag is set
+    if (is_inode_enabled == 1) {
+        out_uint(out_current, entry->inode, widths->inode);
+        out_putc(out_current, ' ');
     }
+    if (print_long_fields(entry, widths) == 0) {
+        print_with_color(path);             // Print the file/directory name in color
+        out_putc(out_current, '\n');
+    }
+}
 
-    // Format the time to include day, date, month, and time
-    if (strftime(time_str, sizeof(time_str),  "%H:%M %d %b", modification_time) == 0) {
-	    printf("Error formatting the time\n");
-	    return;
+/**
+ * @brief Prints the detailed information of a file or directory in long format.
+ *
+ * This function retrieves file statistics once and prints the long format row for them.
+ *
+ * @param path Path to the file or directory to be printed.
+ */
+void print_longformat(char *path) {
+    struct ls_entry entry;                 // Metadata of the file
+    struct long_widths widths;             // Column widths of the row
+
+    // Retrieve file stats
+    memset(&entry, 0, sizeof(entry));
+    if (load_entry(AT_FDCWD, path, listing_statx_mask(), &entry) == -1) {
+        return;
     }
+    measure_long_widths(&entry, 1, &widths);
+    print_path_longformat(path, &entry, &widths);
+}
 
+/**
+ * @brief Prints a directory entry in long format from its preloaded metadata.
+ *
+ * @param dir_fd Open directory containing the entry, used to resolve symbolic links.
+ * @param entry Preloaded metadata of the entry.
+ * @param widths Widths of the columns, measured over every row of the listing.
+ */
+void print_entry_longformat(int dir_fd, struct ls_entry *entry, const struct long_widths *widths) {
+    if (print_long_fields(entry, widths) == 0) {
+        print_entry_with_color(dir_fd, entry, "   ");  // Print the entry name in color
+        out_putc(out_current, '\n');
+    }
+}
 
-    // Print file permissions, number of hard links, owner, group, size, modification time, and name
-    printf("%s ", permissions);            // Print permission string
-    printf("%3ld ", buf.st_nlink);         // Print number of hard links
-    printf("%6s ", ownerInfo->pw_name);  // Print owner's name
-    printf("%6s ", grp->gr_name);         // Print group's name
-    printf("%5ld ", buf.st_size);          // Print file size
-    printf("%5s ", time_str);                // Print formatted modification time
-    print_with_color(path);                 // Print the file/directory name in color
-    printf("\n");
+/**
+ * @brief Prints paths themselves in long format, with their columns aligned.
+ *
+ * Each path is stat'ed exactly once; the same metadata sizes the columns and
+ * fills its row. Paths that cannot be stat'ed are reported and skipped.
+ *
+ * @param paths Paths to print, in listing order.
+ * @param count Number of paths.
+ */
+void list_paths_long_format(char *paths[], int count) {
+    struct ls_entry *entries;       // Metadata of the paths that could be stat'ed
+    char **loaded_paths;            // Path of every loaded entry
+    size_t loaded_count = 0;        // Number of loaded entries
+    struct long_widths widths;      // Column widths over every row
+
+    entries = calloc(count ? count : 1, sizeof(struct ls_entry));
+    loaded_paths = malloc((count ? count : 1) * sizeof(char *));
+    if (entries == NULL || loaded_paths == NULL) {
+        perror("malloc failed");
+        free(entries);
+        free(loaded_paths);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        if (load_entry(AT_FDCWD, paths[i], listing_statx_mask(), &entries[loaded_count]) == 0) {
+            loaded_paths[loaded_count++] = paths[i];
+        }
+    }
+    measure_long_widths(entries, loaded_count, &widths);
+    for (size_t i = 0; i < loaded_count; i++) {
+        print_path_longformat(loaded_paths[i], &entries[i], &widths);
+    }
+    free(entries);
+    free(loaded_paths);
 }
 
 /**
@@ -682,6 +2218,12 @@ void list_directories(char *multiArgs[], int argCount) {
     // Sort the array of paths
     qsort(multiArgs, argCount, sizeof(char *), compare);
 
+    // Long format: fetch every path's metadata once, size the columns over all rows, then print them
+    if (is_long_format_enabled == 1) {
+        list_paths_long_format(multiArgs, argCount);
+        return;
+    }
+
     // Iterate over each argument and retrieve its status
     for (int i = 0; i < argCount; i++) {
         // Retrieve file statistics
@@ -690,23 +2232,18 @@ void list_directories(char *multiArgs[], int argCount) {
             continue; // Skip to the next item if stat fails
         }
 
-        // Print in long format if the flag is set
-        if (is_long_format_enabled == 1) {
-            print_longformat(multiArgs[i]);
+        // Print in column format if the column flag is set
+        if (is_column_output_enabled == 1) {
+            print_column_with_color(multiArgs[i]);
         } else {
-            // Print in column format if the column flag is set
-            if (is_column_output_enabled == 1) {
-                print_column_with_color(multiArgs[i]);
-            } else {
-                // Default print format
-                print_with_color(multiArgs[i]);
-            }
+            // Default print format
+            print_with_color(multiArgs[i]);
         }
     }
 
-    // Print a newline if neither long format nor column format is requested
-    if (is_long_format_enabled == 0 && is_column_output_enabled == 0) {
-        printf("\n");
+    // Print a newline if column format is not requested
+    if (is_column_output_enabled == 0) {
+        out_putc(out_current, '\n');
     }
 }
 
@@ -1,11 +1,100 @@
 #ifndef myls
 #define myls
+#include <sys/types.h>
+#include <time.h>
+
+// Metadata gathered once for every directory entry, so sorting and printing never stat again
+struct ls_entry {
+    char *name;             // Entry name, relative to its directory
+    size_t name_offset;     // Offset of the name inside the table's name arena
+    char *sort_key;         // NUL-terminated key the name sort compares, also in the arena (NULL until prepared)
+    size_t sort_key_offset; // Offset of the sort key inside the table's name arena
+    size_t sort_key_length; // Length of the sort key without its terminator
+    unsigned char d_type;   // File type reported by the directory (DT_UNKNOWN if not reported)
+    unsigned char is_loaded; // Set once the metadata below has been filled by stat (only the requested fields)
+    mode_t mode;            // File type and permission bits
+    off_t size;             // Size in bytes
+    blkcnt_t blocks;        // Number of 512-byte blocks allocated
+    struct timespec atime;  // Last access time
+    struct timespec mtime;  // Last modification time
+    struct timespec ctime;  // Last status change time
+    ino_t inode;            // Inode number
+    nlink_t nlink;          // Number of hard links
+    uid_t uid;              // Owner ID
+    gid_t gid;              // Group ID
+};
+
+// Widths of the long format columns, measured over every row before the first one is printed
+struct long_widths {
+    size_t inode;           // Inode number (with -i)
+    size_t nlink;           // Number of hard links
+    size_t owner;           // Owner name
+    size_t group;           // Group name
+    size_t size;            // Size in bytes
+};
+
+// Growable storage for the entries of one directory
+struct ls_entry_table {
+    struct ls_entry *entries;   // Entry vector, grown geometrically
+    size_t count;               // Number of entries in use
+    size_t capacity;            // Number of entries allocated
+    char *names;                // Arena holding every entry name back to back
+    size_t names_used;          // Bytes used in the name arena
+    size_t names_capacity;      // Bytes allocated for the name arena
+    int dir_fd;                 // Open directory the entries belong to (-1 if none); entries are stat'ed relative to it
+};
+
+// Raw directory entry handed out by the getdents64 reader
+struct ls_dirent {
+    const char *name;       // NUL-terminated name, pointing into the reader's buffer
+    size_t name_length;     // Length of the name in bytes
+    unsigned char type;     // DT_* file type, DT_UNKNOWN if the filesystem does not report it
+    ino_t inode;            // Inode number reported by the directory
+};
+
+// Directory reader that calls getdents64 directly into a caller-supplied buffer
+struct dirent_reader {
+    int fd;                 // Open directory file descriptor
+    char *buffer;           // Buffer receiving linux_dirent64 records
+    size_t buffer_size;     // Size of the buffer in bytes
+    size_t position;        // Offset of the next record to parse
+    size_t length;          // Number of bytes returned by the last getdents64 call
+};
+
+// Growable list of names, used to collect the subdirectories a listing shows
+struct path_list {
+    char **paths;           // Copied names
+    size_t count;           // Number of names
+    size_t capacity;        // Number of slots allocated
+};
+
+// List the listing functions add every subdirectory they print to on the calling thread (NULL = none)
+extern __thread struct path_list *subdirectory_sink;
+
 // Function declarations
+void dirent_reader_init(struct dirent_reader *reader, int fd, char *buffer, size_t buffer_size);
+ssize_t dirent_reader_fill(struct dirent_reader *reader);
+int dirent_reader_next(struct dirent_reader *reader, struct ls_dirent *dirent);
+int read_directory_entries(struct ls_entry_table *table);
+void entry_table_init(struct ls_entry_table *table);
+struct ls_entry *entry_table_add(struct ls_entry_table *table, const char *name, size_t name_length);
+int entry_table_prepare_sort_keys(struct ls_entry_table *table);
+void entry_table_free(struct ls_entry_table *table);
+int path_list_add(struct path_list *list, const char *path);
+void path_list_free(struct path_list *list);
+int load_entry(int dir_fd, const char *name, unsigned int mask, struct ls_entry *entry);
+struct statx;
+void fill_entry_from_statx(struct ls_entry *entry, const struct statx *file_statx);
 void print_with_color(char *path);
 void print_column_with_color(char *path);
 void do_ls(char *input_path);
+void do_ls_at(int base_fd, char *input_path);
 void list_directory_long_format(char *input_path);
+void list_directory_long_format_at(int base_fd, char *input_path);
 void print_longformat(char *path);
+void print_entry_longformat(int dir_fd, struct ls_entry *entry, const struct long_widths *widths);
+void measure_long_widths(const struct ls_entry *entries, size_t count, struct long_widths *widths);
+void list_paths_long_format(char *paths[], int count);
 void list_directories(char *multiArgs[], int argCount);
 int compare(const void *a, const void *b);
 int compare_with_hidden(const void *a, const void *b);
@@ -0,0 +1,236 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include "ls_Layout.h"
+#include "ls_Output.h"
+
+#define DEFAULT_LINE_WIDTH 80   // Line width when neither the terminal nor COLUMNS gives one
+#define COLUMN_GAP 2            // Spaces between two columns
+#define MIN_COLUMN_WIDTH 3      // Narrowest column: one character and the gap
+
+// Range-maximum table over the cell widths: level k holds the maximum of every
+// run of 2^k cells, so the widest cell of any range is found with two lookups
+struct width_table {
+    uint16_t **levels;          // levels[k][i] = widest of cells [i, i + 2^k)
+    size_t level_count;         // Number of levels
+};
+
+/**
+ * @brief Returns the width of the line the columns are packed into.
+ *
+ * The width of the terminal on standard output is used when there is one,
+ * then the `COLUMNS` environment variable, then 80 columns.
+ *
+ * @return size_t Line width in columns (at least 1).
+ */
+size_t terminal_line_width(void) {
+    struct winsize window;      // Size of the terminal
+    const char *columns = getenv("COLUMNS");
+    char *end;
+    unsigned long value;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 && window.ws_col > 0) {
+        return window.ws_col;
+    }
+    if (columns != NULL && *columns != '\0') {
+        value = strtoul(columns, &end, 10);
+        if (*end == '\0' && value > 0) {
+            return value;
+        }
+    }
+    return DEFAULT_LINE_WIDTH;
+}
+
+/**
+ * @brief Returns the number of columns a name takes on the terminal.
+ *
+ * UTF-8 continuation bytes take no column of their own, so multibyte
+ * characters count as one column.
+ *
+ * @param text NUL-terminated text.
+ * @return uint16_t Display width, capped at UINT16_MAX.
+ */
+uint16_t text_display_width(const char *text) {
+    size_t width = 0;
+
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) {
+        if ((*c & 0xC0) != 0x80) {
+            width++;
+        }
+    }
+    return width < UINT16_MAX ? (uint16_t)width : UINT16_MAX;
+}
+
+/**
+ * @brief Builds the range-maximum table of the cell widths.
+ *
+ * @param table Table to build.
+ * @param widths Width of every cell.
+ * @param count Number of cells (at least 1).
+ * @return int 0 on success, -1 on allocation failure.
+ */
+static int width_table_build(struct width_table *table, const uint16_t *widths, size_t count) {
+    table->level_count = 1;
+    while (((size_t)1 << table->level_count) <= count) {
+        table->level_count++;
+    }
+    table->levels = calloc(table->level_count, sizeof(uint16_t *));
+    if (table->levels == NULL) {
+        return -1;
+    }
+    table->levels[0] = (uint16_t *)widths;
+    for (size_t k = 1; k < table->level_count; k++) {
+        size_t half = (size_t)1 << (k - 1);
+        size_t length = count - ((size_t)1 << k) + 1;
+        uint16_t *level = malloc(length * sizeof(uint16_t));
+        if (level == NULL) {
+            table->level_count = k;
+            return -1;
+        }
+        for (size_t i = 0; i < length; i++) {
+            uint16_t left = table->levels[k - 1][i];
+            uint16_t right = table->levels[k - 1][i + half];
+            level[i] = left > right ? left : right;
+        }
+        table->levels[k] = level;
+    }
+    return 0;
+}
+
+/**
+ * @brief Releases a range-maximum table; the widths it was built from are left alone.
+ *
+ * @param table Table to release.
+ */
+static void width_table_free(struct width_table *table) {
+    if (table->levels == NULL) {
+        return;
+    }
+    for (size_t k = 1; k < table->level_count; k++) {
+        free(table->levels[k]);
+    }
+    free(table->levels);
+}
+
+/**
+ * @brief Returns the widest cell of [begin, end).
+ *
+ * @param table Range-maximum table of the cells.
+ * @param begin First cell of the range.
+ * @param end One past the last cell of the range (greater than `begin`).
+ * @return size_t Width of the widest cell.
+ */
+static size_t width_table_max(const struct width_table *table, size_t begin, size_t end) {
+    size_t k = 0;
+    uint16_t left;
+    uint16_t right;
+
+    while (((size_t)2 << k) <= end - begin) {
+        k++;
+    }
+    left = table->levels[k][begin];
+    right = table->levels[k][end - ((size_t)1 << k)];
+    return left > right ? left : right;
+}
+
+/**
+ * @brief Returns the width a column takes, gap included.
+ *
+ * @param table Range-maximum table of the cells.
+ * @param count Number of cells.
+ * @param rows Number of rows; column `column` holds cells [column * rows, (column + 1) * rows).
+ * @param column Column to measure.
+ * @param is_last Nonzero for the last column, which has no gap after it.
+ * @return size_t Width of the column.
+ */
+static size_t column_width(const struct width_table *table, size_t count, size_t rows, size_t column, int is_last) {
+    size_t begin = column * rows;
+    size_t end = begin + rows < count ? begin + rows : count;
+    size_t width = width_table_max(table, begin, end) + (is_last ? 0 : COLUMN_GAP);
+
+    return width > MIN_COLUMN_WIDTH ? width : MIN_COLUMN_WIDTH;
+}
+
+/**
+ * @brief Prints cells in as many columns as fit on a line, filled top to bottom.
+ *
+ * Like GNU ls, every column count from the widest possible down is tried and
+ * the first layout narrower than the line wins; a column is as wide as its
+ * widest cell plus a two-space gap. Columns are contiguous runs of cells, so
+ * each column width is one range-maximum lookup and a layout of C columns
+ * costs O(C) after an O(n log n) table build. Rows go straight into the
+ * current output buffer, which hands them to the terminal in large chunks.
+ *
+ * @param widths Display width of every cell.
+ * @param count Number of cells.
+ * @param line_width Width of the line to fill.
+ * @param print_cell Prints one cell without padding.
+ * @param arg Argument passed to `print_cell`.
+ */
+void print_in_columns(const uint16_t *widths, size_t count, size_t line_width, layout_cell_fn print_cell, void *arg) {
+    struct width_table table = { NULL, 0 };
+    size_t max_columns = line_width / MIN_COLUMN_WIDTH;
+    size_t rows = count;            // Rows of the chosen layout (one column unless more fit)
+    size_t tried_rows = 0;          // Rows of the last layout tried
+    size_t *widths_of_columns;      // Width of every column of the chosen layout
+
+    if (count == 0) {
+        return;
+    }
+    if (max_columns > count) {
+        max_columns = count;
+    }
+    if (max_columns > 1 && width_table_build(&table, widths, count) == 0) {
+        for (size_t columns = max_columns; columns > 1; columns--) {
+            size_t candidate_rows = (count + columns - 1) / columns;
+            size_t used_columns = (count + candidate_rows - 1) / candidate_rows;
+            size_t length = 0;
+
+            // Column counts that give the same number of rows give the same layout
+            if (candidate_rows == tried_rows) {
+                continue;
+            }
+            tried_rows = candidate_rows;
+            for (size_t column = 0; column < used_columns && length < line_width; column++) {
+                length += column_width(&table, count, candidate_rows, column, column == used_columns - 1);
+            }
+            if (length < line_width) {
+                rows = candidate_rows;
+                break;
+            }
+        }
+    }
+
+    // Measure the chosen layout once, then print it row by row
+    size_t column_count = (count + rows - 1) / rows;
+    widths_of_columns = malloc(column_count * sizeof(size_t));
+    if (widths_of_columns == NULL) {
+        rows = count;
+        column_count = 1;
+    } else if (column_count > 1) {
+        for (size_t column = 0; column < column_count; column++) {
+            widths_of_columns[column] = column_width(&table, count, rows, column, column == column_count - 1);
+        }
+    }
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t column = 0; column < column_count; column++) {
+            size_t index = column * rows + row;
+            if (index >= count) {
+                break;
+            }
+            print_cell(index, arg);
+            // Pad up to the next column, if this row has one
+            if (column + 1 < column_count && index + rows < count) {
+                for (size_t pad = widths[index]; pad < widths_of_columns[column]; pad++) {
+                    out_putc(out_current, ' ');
+                }
+            }
+        }
+        out_putc(out_current, '\n');
+    }
+
+    free(widths_of_columns);
+    width_table_free(&table);
+}
@@ -0,0 +1,13 @@
+#ifndef ls_layout
+#define ls_layout
+#include <stddef.h>
+#include <stdint.h>
+
+// Prints the cell at `index` without any padding
+typedef void (*layout_cell_fn)(size_t index, void *arg);
+
+// Function declarations
+size_t terminal_line_width(void);
+uint16_t text_display_width(const char *text);
+void print_in_columns(const uint16_t *widths, size_t count, size_t line_width, layout_cell_fn print_cell, void *arg);
+#endif
@@ -0,0 +1,198 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "ls_Output.h"
+
+#define FD_BUFFER_SIZE (256 * 1024)     // Bytes collected before a write() to a descriptor
+#define INITIAL_MEMORY_BUFFER_SIZE 4096 // Bytes allocated for a new in-memory buffer
+
+struct out_buf stdout_buf = { NULL, 0, 0, STDOUT_FILENO };
+__thread struct out_buf *out_current = &stdout_buf;
+
+/**
+ * @brief Initializes an empty output buffer.
+ *
+ * Nothing is allocated until the first byte is written.
+ *
+ * @param out Buffer to initialize.
+ * @param fd Descriptor to write to when the buffer fills up, or -1 for a buffer
+ *           that keeps everything in memory until the caller takes it.
+ */
+void out_init(struct out_buf *out, int fd) {
+    out->data = NULL;
+    out->length = 0;
+    out->capacity = 0;
+    out->fd = fd;
+}
+
+/**
+ * @brief Releases the memory of an output buffer without writing it.
+ *
+ * @param out Buffer to release; it is left empty and can be reused.
+ */
+void out_free(struct out_buf *out) {
+    free(out->data);
+    out_init(out, out->fd);
+}
+
+/**
+ * @brief Writes the buffered bytes to the buffer's descriptor.
+ *
+ * In-memory buffers (fd -1) are left untouched.
+ *
+ * @param out Buffer to flush.
+ */
+void out_flush(struct out_buf *out) {
+    size_t written = 0;     // Bytes written so far
+
+    if (out->fd == -1) {
+        return;
+    }
+    while (written < out->length) {
+        ssize_t result = write(out->fd, out->data + written, out->length - written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("write failed");
+            break;  // Drop the rest rather than retrying forever
+        }
+        written += (size_t)result;
+    }
+    out->length = 0;
+}
+
+/**
+ * @brief Makes room for `length` more bytes, flushing or growing the buffer.
+ *
+ * @param out Buffer to make room in.
+ * @param length Number of bytes about to be appended.
+ * @return int 0 if the bytes fit, -1 if they have to be written directly (descriptor
+ *         buffers only) or memory ran out.
+ */
+static int out_reserve(struct out_buf *out, size_t length) {
+    size_t new_capacity;
+    char *new_data;
+
+    if (out->length + length <= out->capacity) {
+        return 0;
+    }
+    if (out->fd != -1) {
+        out_flush(out);
+        if (out->capacity == 0) {
+            out->data = malloc(FD_BUFFER_SIZE);
+            if (out->data == NULL) {
+                return -1;
+            }
+            out->capacity = FD_BUFFER_SIZE;
+        }
+        return length <= out->capacity ? 0 : -1;
+    }
+
+    new_capacity = out->capacity ? out->capacity : INITIAL_MEMORY_BUFFER_SIZE;
+    while (out->length + length > new_capacity) {
+        new_capacity *= 2;
+    }
+    new_data = realloc(out->data, new_capacity);
+    if (new_data == NULL) {
+        perror("realloc failed");
+        return -1;
+    }
+    out->data = new_data;
+    out->capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * @brief Appends bytes to an output buffer.
+ *
+ * @param out Buffer to append to.
+ * @param data Bytes to append.
+ * @param length Number of bytes.
+ */
+void out_write(struct out_buf *out, const char *data, size_t length) {
+    if (length == 0) {
+        return;     // Nothing to copy, and an empty buffer may not have any memory yet
+    }
+    if (out_reserve(out, length) == -1) {
+        // Too large for a descriptor buffer (already flushed): write it straight through
+        if (out->fd != -1) {
+            struct out_buf direct = { (char *)data, length, length, out->fd };
+            out_flush(&direct);
+        }
+        return;
+    }
+    memcpy(out->data + out->length, data, length);
+    out->length += length;
+}
+
+/**
+ * @brief Appends a NUL-terminated string to an output buffer.
+ *
+ * @param out Buffer to append to.
+ * @param text String to append.
+ */
+void out_puts(struct out_buf *out, const char *text) {
+    out_write(out, text, strlen(text));
+}
+
+/**
+ * @brief Appends a single character to an output buffer.
+ *
+ * @param out Buffer to append to.
+ * @param c Character to append.
+ */
+void out_putc(struct out_buf *out, char c) {
+    if (out->length < out->capacity) {
+        out->data[out->length++] = c;
+    } else {
+        out_write(out, &c, 1);
+    }
+}
+
+/**
+ * @brief Appends a string right-aligned in a field, like printf's "%*s".
+ *
+ * @param out Buffer to append to.
+ * @param text String to append.
+ * @param width Minimum field width; shorter strings are padded with spaces on the left.
+ */
+void out_padded(struct out_buf *out, const char *text, size_t width) {
+    size_t length = strlen(text);
+
+    while (length < width) {
+        out_putc(out, ' ');
+        width--;
+    }
+    out_write(out, text, length);
+}
+
+/**
+ * @brief Appends an unsigned number right-aligned in a field, like printf's "%*llu".
+ *
+ * The digits are produced by hand; this runs several times for every row of
+ * a long listing.
+ *
+ * @param out Buffer to append to.
+ * @param value Number to append.
+ * @param width Minimum field width; shorter numbers are padded with spaces on the left.
+ */
+void out_uint(struct out_buf *out, unsigned long long value, size_t width) {
+    char digits[24];                        // Enough for any 64-bit value
+    char *first = digits + sizeof(digits);  // Digits are written backwards from the end
+    size_t length;
+
+    do {
+        *--first = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    length = (size_t)(digits + sizeof(digits) - first);
+
+    while (length < width) {
+        out_putc(out, ' ');
+        width--;
+    }
+    out_write(out, first, length);
+}
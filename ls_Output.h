@@ -0,0 +1,28 @@
+#ifndef ls_output
+#define ls_output
+#include <stddef.h>
+
+// Output buffer that collects formatted text and writes it out in large chunks
+struct out_buf {
+    char *data;             // Buffered bytes
+    size_t length;          // Number of bytes in use
+    size_t capacity;        // Number of bytes allocated
+    int fd;                 // Descriptor written to when the buffer fills up, or -1 to grow in memory instead
+};
+
+// Buffer in front of standard output, flushed when full and at exit
+extern struct out_buf stdout_buf;
+
+// Buffer the listing functions print to on the calling thread (standard output by default)
+extern __thread struct out_buf *out_current;
+
+// Function declarations
+void out_init(struct out_buf *out, int fd);
+void out_free(struct out_buf *out);
+void out_flush(struct out_buf *out);
+void out_write(struct out_buf *out, const char *data, size_t length);
+void out_puts(struct out_buf *out, const char *text);
+void out_putc(struct out_buf *out, char c);
+void out_padded(struct out_buf *out, const char *text, size_t width);
+void out_uint(struct out_buf *out, unsigned long long value, size_t width);
+#endif
@@ -0,0 +1,347 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdint.h>
+#include "ls_Pool.h"
+
+#define INITIAL_DEQUE_CAPACITY 64   // Tasks a deque holds before it first grows
+
+extern size_t worker_thread_count;  // Requested number of worker threads (0 = online CPUs)
+
+// Task waiting in a deque
+struct pool_task {
+    pool_task_fn fn;                // Function to run
+    void *arg;                      // Argument passed to the function
+    struct pool_group *group;       // Group notified when the task finishes
+};
+
+// Chunk of a parallel loop, run as one task
+struct pool_range {
+    pool_range_fn fn;               // Function run on the chunk
+    void *arg;                      // Argument passed to the function
+    size_t begin;                   // First index of the chunk
+    size_t end;                     // One past the last index of the chunk
+};
+
+// Double-ended task queue: its owner pushes and pops the newest task, other threads steal the oldest
+struct pool_deque {
+    pthread_mutex_t lock;           // Serializes the owner and thieves
+    struct pool_task *tasks;        // Circular task buffer
+    size_t capacity;                // Slots in the buffer
+    size_t head;                    // Index of the oldest task
+    size_t length;                  // Number of queued tasks
+};
+
+// Shared worker pool, started on first use. Every worker owns a deque; one more
+// deque takes the tasks submitted by threads outside the pool.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_available = PTHREAD_COND_INITIALIZER;   // Signaled when a task is queued
+static pthread_cond_t pool_task_finished = PTHREAD_COND_INITIALIZER;    // Broadcast when a task finishes
+static struct pool_deque *deques;   // One deque per worker, then the shared one
+static size_t deque_count;          // Number of deques (workers + 1)
+static size_t started_threads;      // Worker threads running
+static int pool_state = 0;          // 0 = not started, 1 = workers running, -1 = no worker could be started
+static size_t queued_tasks;         // Tasks waiting in all deques (accessed atomically)
+static __thread size_t own_deque = SIZE_MAX;   // Deque of the calling worker (SIZE_MAX outside the pool)
+
+/**
+ * @brief Returns the number of threads the pool runs.
+ *
+ * This is the `--threads` value, or the number of online CPUs by default.
+ *
+ * @return size_t Number of worker threads (at least 1).
+ */
+size_t pool_thread_count(void) {
+    long online_cpus;
+
+    if (worker_thread_count > 0) {
+        return worker_thread_count;
+    }
+    online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return online_cpus > 0 ? (size_t)online_cpus : 1;
+}
+
+/**
+ * @brief Appends a task to a deque, growing it if needed.
+ *
+ * @param deque Deque to push to.
+ * @param task Task to queue.
+ * @return int 0 on success, -1 on allocation failure.
+ */
+static int deque_push(struct pool_deque *deque, const struct pool_task *task) {
+    pthread_mutex_lock(&deque->lock);
+    // Grow the circular buffer, unrolling it so the oldest task is first again
+    if (deque->length == deque->capacity) {
+        size_t new_capacity = deque->capacity ? deque->capacity * 2 : INITIAL_DEQUE_CAPACITY;
+        struct pool_task *new_tasks = malloc(new_capacity * sizeof(struct pool_task));
+        if (new_tasks == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < deque->length; i++) {
+            new_tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = new_tasks;
+        deque->capacity = new_capacity;
+        deque->head = 0;
+    }
+    deque->tasks[(deque->head + deque->length) % deque->capacity] = *task;
+    deque->length++;
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+/**
+ * @brief Takes a task off a deque.
+ *
+ * @param deque Deque to take from.
+ * @param is_owner Nonzero to take the newest task (owner), zero to steal the oldest.
+ * @param task Filled with the task.
+ * @return int 1 if a task was taken, 0 if the deque is empty.
+ */
+static int deque_take(struct pool_deque *deque, int is_owner, struct pool_task *task) {
+    int taken = 0;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->length > 0) {
+        if (is_owner) {
+            *task = deque->tasks[(deque->head + deque->length - 1) % deque->capacity];
+        } else {
+            *task = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        }
+        deque->length--;
+        taken = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return taken;
+}
+
+/**
+ * @brief Finds a task for the calling thread.
+ *
+ * A worker first pops the newest task of its own deque, which keeps nested
+ * work depth-first and cache-warm; otherwise it steals the oldest task of
+ * another deque, which tends to be the largest piece of outstanding work.
+ *
+ * @param task Filled with the task.
+ * @return int 1 if a task was found, 0 if every deque is empty.
+ */
+static int find_task(struct pool_task *task) {
+    size_t start = own_deque == SIZE_MAX ? deque_count - 1 : own_deque;
+
+    if (__atomic_load_n(&queued_tasks, __ATOMIC_ACQUIRE) == 0) {
+        return 0;
+    }
+    if (own_deque != SIZE_MAX && deque_take(&deques[own_deque], 1, task)) {
+        __atomic_sub_fetch(&queued_tasks, 1, __ATOMIC_ACQ_REL);
+        return 1;
+    }
+    for (size_t i = 1; i <= deque_count; i++) {
+        if (deque_take(&deques[(start + i) % deque_count], 0, task)) {
+            __atomic_sub_fetch(&queued_tasks, 1, __ATOMIC_ACQ_REL);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs a task and marks it finished in its group.
+ *
+ * @param task Task to run; the pool lock must not be held.
+ */
+static void run_task(const struct pool_task *task) {
+    task->fn(task->arg);
+
+    pthread_mutex_lock(&pool_lock);
+    task->group->pending--;
+    pthread_cond_broadcast(&pool_task_finished);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * @brief Main loop of a worker thread: run or steal tasks forever.
+ *
+ * @param arg Index of the worker's deque.
+ * @return void* Never returns.
+ */
+static void *worker_main(void *arg) {
+    struct pool_task task;
+
+    own_deque = (size_t)(uintptr_t)arg;
+    for (;;) {
+        if (find_task(&task)) {
+            run_task(&task);
+            continue;
+        }
+        pthread_mutex_lock(&pool_lock);
+        while (__atomic_load_n(&queued_tasks, __ATOMIC_ACQUIRE) == 0) {
+            pthread_cond_wait(&pool_work_available, &pool_lock);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Creates the deques and starts the worker threads. The pool lock must be held.
+ *
+ * If no thread can be created, submitted tasks run directly on the submitting thread.
+ */
+static void start_workers(void) {
+    size_t wanted = pool_thread_count();
+    pthread_t thread;
+
+    deques = calloc(wanted + 1, sizeof(struct pool_deque));
+    if (deques == NULL) {
+        pool_state = -1;
+        return;
+    }
+    for (size_t i = 0; i <= wanted; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+    }
+    deque_count = wanted + 1;
+
+    while (started_threads < wanted) {
+        if (pthread_create(&thread, NULL, worker_main, (void *)(uintptr_t)started_threads) != 0) {
+            perror("pthread_create failed");
+            break;
+        }
+        pthread_detach(thread);
+        started_threads++;
+    }
+    // Deques of workers that could not be started are still stolen from, so nothing is lost
+    pool_state = started_threads > 0 ? 1 : -1;
+}
+
+/**
+ * @brief Initializes an empty task group.
+ *
+ * @param group Group to initialize.
+ */
+void pool_group_init(struct pool_group *group) {
+    group->pending = 0;
+}
+
+/**
+ * @brief Queues a task on the shared pool.
+ *
+ * A worker queues on its own deque, any other thread on the shared deque.
+ *
+ * @param group Group the task belongs to; `pool_wait` on it waits for the task.
+ * @param fn Function to run.
+ * @param arg Argument passed to the function.
+ */
+void pool_submit(struct pool_group *group, pool_task_fn fn, void *arg) {
+    struct pool_task task = { fn, arg, group };
+
+    pthread_mutex_lock(&pool_lock);
+    if (pool_state == 0) {
+        start_workers();
+    }
+    if (pool_state == -1) {
+        // No worker to hand the task to: run it right here instead
+        pthread_mutex_unlock(&pool_lock);
+        fn(arg);
+        return;
+    }
+    group->pending++;
+    pthread_mutex_unlock(&pool_lock);
+
+    if (deque_push(&deques[own_deque == SIZE_MAX ? deque_count - 1 : own_deque], &task) == -1) {
+        // Out of memory: run the task right here instead
+        run_task(&task);
+        return;
+    }
+    __atomic_add_fetch(&queued_tasks, 1, __ATOMIC_ACQ_REL);
+
+    pthread_mutex_lock(&pool_lock);
+    pthread_cond_signal(&pool_work_available);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * @brief Waits until every task of a group has finished.
+ *
+ * While waiting, the caller runs or steals queued tasks itself, so tasks may
+ * submit and wait for nested work without exhausting the pool.
+ *
+ * @param group Group to wait for.
+ */
+void pool_wait(struct pool_group *group) {
+    struct pool_task task;
+
+    pthread_mutex_lock(&pool_lock);
+    while (group->pending > 0) {
+        pthread_mutex_unlock(&pool_lock);
+        if (find_task(&task)) {
+            run_task(&task);
+            pthread_mutex_lock(&pool_lock);
+            continue;
+        }
+        pthread_mutex_lock(&pool_lock);
+        // Sleep only while there is nothing to help with; a finishing task wakes us up
+        if (group->pending > 0 && __atomic_load_n(&queued_tasks, __ATOMIC_ACQUIRE) == 0) {
+            pthread_cond_wait(&pool_task_finished, &pool_lock);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * @brief Runs one chunk of a parallel loop.
+ *
+ * @param arg The chunk (struct pool_range).
+ */
+static void run_range(void *arg) {
+    struct pool_range *range = arg;
+
+    range->fn(range->begin, range->end, range->arg);
+}
+
+/**
+ * @brief Splits [0, count) into chunks and runs them on the pool.
+ *
+ * Each thread gets a few chunks so uneven chunks still balance out. Loops too
+ * small to split, or a pool of one thread, run directly on the caller.
+ *
+ * @param count Number of indices.
+ * @param min_chunk Smallest chunk worth handing to another thread.
+ * @param fn Function run on every chunk.
+ * @param arg Argument passed to the function.
+ */
+void pool_parallel_for(size_t count, size_t min_chunk, pool_range_fn fn, void *arg) {
+    size_t threads = pool_thread_count();
+    size_t chunk = count / (threads * 4) + 1;   // Roughly four chunks per thread
+    size_t chunk_count;
+    struct pool_range *ranges;
+    struct pool_group group;
+
+    if (chunk < min_chunk) {
+        chunk = min_chunk;
+    }
+    if (threads == 1 || count <= chunk) {
+        fn(0, count, arg);
+        return;
+    }
+
+    chunk_count = (count + chunk - 1) / chunk;
+    ranges = malloc(chunk_count * sizeof(struct pool_range));
+    if (ranges == NULL) {
+        fn(0, count, arg);
+        return;
+    }
+    pool_group_init(&group);
+    for (size_t i = 0; i < chunk_count; i++) {
+        ranges[i].fn = fn;
+        ranges[i].arg = arg;
+        ranges[i].begin = i * chunk;
+        ranges[i].end = (i + 1) * chunk < count ? (i + 1) * chunk : count;
+        pool_submit(&group, run_range, &ranges[i]);
+    }
+    pool_wait(&group);
+    free(ranges);
+}
@@ -0,0 +1,22 @@
+#ifndef ls_pool
+#define ls_pool
+#include <stddef.h>
+
+// Function run by a pool task
+typedef void (*pool_task_fn)(void *arg);
+
+// Function run on one chunk [begin, end) of a parallel loop
+typedef void (*pool_range_fn)(size_t begin, size_t end, void *arg);
+
+// Set of submitted tasks that a caller can wait for
+struct pool_group {
+    size_t pending;         // Tasks submitted to the group and not finished yet
+};
+
+// Function declarations
+size_t pool_thread_count(void);
+void pool_group_init(struct pool_group *group);
+void pool_submit(struct pool_group *group, pool_task_fn fn, void *arg);
+void pool_wait(struct pool_group *group);
+void pool_parallel_for(size_t count, size_t min_chunk, pool_range_fn fn, void *arg);
+#endif
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ls_Functions.h"
+#include "ls_Output.h"
+#include "ls_Pool.h"
+#include "ls_Recurse.h"
+
+#define INITIAL_WALK_DEPTH 16      // Directory levels allocated for a new depth-first walk
+
+extern uint8_t is_long_format_enabled;         // Flag for long format output
+extern uint8_t is_depth_first_enabled;         // Flag to walk the tree depth-first on one thread with bounded memory
+extern size_t walk_fd_budget;                  // Directory descriptors a depth-first walk keeps open
+
+// One directory of a recursive listing
+struct dir_node {
+    char *path;                         // Path of the directory, as printed in its header
+    struct out_buf output;              // Listing of the directory, rendered in memory
+    struct path_list subdirectories;    // Names of the subdirectories the listing shows, in listing order
+    struct dir_node *children;          // One node per subdirectory
+    int is_done;                        // Set once the listing and the children are ready (under tree_lock)
+};
+
+// Directory on the current path of a depth-first walk
+struct walk_frame {
+    char *path;                         // Path of the directory, as printed in its header
+    int dir_fd;                         // Open directory, or -1 if it was closed to stay within the budget
+    struct path_list subdirectories;    // Names of the subdirectories still to visit, in listing order
+    size_t next;                        // Index of the next subdirectory to visit
+};
+
+// Shared by the directory tasks of a traversal and the thread emitting their output
+static pthread_mutex_t tree_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tree_node_done = PTHREAD_COND_INITIALIZER;   // Broadcast when a node is done
+static struct pool_group tree_group;    // Every directory task of the traversal
+
+/**
+ * @brief Joins a directory path and an entry name.
+ *
+ * @param directory Directory path.
+ * @param name Entry name.
+ * @return char* Newly allocated path, or NULL on allocation failure.
+ */
+static char *join_path(const char *directory, const char *name) {
+    size_t directory_length = strlen(directory);
+    size_t name_length = strlen(name);
+    int needs_slash = directory_length > 0 && directory[directory_length - 1] != '/';
+    char *path = malloc(directory_length + needs_slash + name_length + 1);
+
+    if (path == NULL) {
+        perror("malloc failed");
+        return NULL;
+    }
+    memcpy(path, directory, directory_length);
+    if (needs_slash) {
+        path[directory_length] = '/';
+    }
+    memcpy(path + directory_length + needs_slash, name, name_length + 1);
+    return path;
+}
+
+/**
+ * @brief Lists one directory of the tree as a pool task.
+ *
+ * The directory is enumerated, stat'ed and sorted exactly as a plain listing
+ * would do it, but the output goes into the node's own in-memory buffer and
+ * the subdirectories it shows are collected. A task is then queued for every
+ * subdirectory, so the traversal spreads over the pool as it discovers work.
+ *
+ * @param arg The directory (struct dir_node).
+ */
+static void run_directory_task(void *arg) {
+    struct dir_node *node = arg;
+    struct out_buf *previous_out = out_current;
+    struct path_list *previous_sink = subdirectory_sink;
+    size_t child_count;
+
+    out_init(&node->output, -1);
+    out_current = &node->output;
+    subdirectory_sink = &node->subdirectories;
+    if (is_long_format_enabled == 1) {
+        list_directory_long_format(node->path);
+    } else {
+        do_ls(node->path);
+    }
+    out_current = previous_out;
+    subdirectory_sink = previous_sink;
+
+    child_count = node->subdirectories.count;
+    if (child_count > 0) {
+        node->children = calloc(child_count, sizeof(struct dir_node));
+        if (node->children == NULL) {
+            perror("calloc failed");
+            path_list_free(&node->subdirectories);
+        }
+    }
+    for (size_t i = 0; i < node->subdirectories.count; i++) {
+        struct dir_node *child = &node->children[i];
+        child->path = join_path(node->path, node->subdirectories.paths[i]);
+        if (child->path == NULL) {
+            child->is_done = 1;     // Nothing to list; the emitter skips it
+            continue;
+        }
+        pool_submit(&tree_group, run_directory_task, child);
+    }
+
+    pthread_mutex_lock(&tree_lock);
+    node->is_done = 1;
+    pthread_cond_broadcast(&tree_node_done);
+    pthread_mutex_unlock(&tree_lock);
+}
+
+/**
+ * @brief Writes a node and its subtree to the output in sequential order, then releases it.
+ *
+ * Nodes are emitted depth-first in listing order, waiting for each one to be
+ * done, so the output is the same as a sequential traversal would print no
+ * matter which thread listed which directory.
+ *
+ * @param node Node to emit.
+ * @param is_separated Nonzero to print a blank line before the node's header.
+ */
+static void emit_directory(struct dir_node *node, int is_separated) {
+    pthread_mutex_lock(&tree_lock);
+    while (node->is_done == 0) {
+        pthread_cond_wait(&tree_node_done, &tree_lock);
+    }
+    pthread_mutex_unlock(&tree_lock);
+
+    if (node->path != NULL) {
+        if (is_separated) {
+            out_putc(out_current, '\n');
+        }
+        out_puts(out_current, node->path);
+        out_puts(out_current, ":\n");
+        out_write(out_current, node->output.data, node->output.length);
+    }
+    out_free(&node->output);
+
+    for (size_t i = 0; i < node->subdirectories.count; i++) {
+        emit_directory(&node->children[i], 1);
+    }
+    for (size_t i = 0; i < node->subdirectories.count; i++) {
+        free(node->children[i].path);
+    }
+    free(node->children);
+    path_list_free(&node->subdirectories);
+}
+
+/**
+ * @brief Prints the header and listing of one directory of a depth-first walk.
+ *
+ * @param frame Directory to list; its subdirectories are collected into the frame.
+ * @param is_separated Nonzero to print a blank line before the header.
+ */
+static void walk_list_directory(struct walk_frame *frame, int is_separated) {
+    struct path_list *previous_sink = subdirectory_sink;
+
+    if (is_separated) {
+        out_putc(out_current, '\n');
+    }
+    out_puts(out_current, frame->path);
+    out_puts(out_current, ":\n");
+
+    // List through the open descriptor when there is one, otherwise reopen by path
+    subdirectory_sink = &frame->subdirectories;
+    if (is_long_format_enabled == 1) {
+        list_directory_long_format_at(frame->dir_fd != -1 ? frame->dir_fd : AT_FDCWD, frame->dir_fd != -1 ? "." : frame->path);
+    } else {
+        do_ls_at(frame->dir_fd != -1 ? frame->dir_fd : AT_FDCWD, frame->dir_fd != -1 ? "." : frame->path);
+    }
+    subdirectory_sink = previous_sink;
+}
+
+/**
+ * @brief Lists a directory tree depth-first on the calling thread with bounded memory.
+ *
+ * Only the directories on the current path are remembered, each with the
+ * names of the subdirectories it still has to visit; every directory's entry
+ * table is released as soon as it has been printed and the output streams
+ * out as it is produced. Peak memory is therefore proportional to the depth
+ * of the tree times its widest directory. Up to `--fd-budget` directories of
+ * the path stay open so their children are opened relative to them; deeper
+ * directories are closed after listing and their children reopened by path.
+ *
+ * @param path Directory at the root of the tree.
+ * @param is_separated Nonzero to print a blank line before the first header.
+ */
+static void walk_directory_tree(const char *path, int is_separated) {
+    struct walk_frame *stack;           // Directories on the current path, root first
+    size_t capacity = INITIAL_WALK_DEPTH;
+    size_t depth = 0;
+    size_t open_count = 0;              // Descriptors held by the frames
+
+    stack = malloc(capacity * sizeof(struct walk_frame));
+    if (stack == NULL) {
+        perror("malloc failed");
+        return;
+    }
+    memset(&stack[0], 0, sizeof(struct walk_frame));
+    stack[0].path = strdup(path);
+    if (stack[0].path == NULL) {
+        perror("strdup failed");
+        free(stack);
+        return;
+    }
+    stack[0].dir_fd = -1;
+    if (walk_fd_budget > 0) {
+        stack[0].dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        open_count += stack[0].dir_fd != -1;
+    }
+    walk_list_directory(&stack[0], is_separated);
+    depth = 1;
+
+    while (depth > 0) {
+        struct walk_frame *frame = &stack[depth - 1];
+        struct walk_frame *child;
+        const char *name;
+
+        // Every subdirectory visited: leave the directory
+        if (frame->next == frame->subdirectories.count) {
+            if (frame->dir_fd != -1) {
+                close(frame->dir_fd);
+                open_count--;
+            }
+            path_list_free(&frame->subdirectories);
+            free(frame->path);
+            depth--;
+            continue;
+        }
+
+        if (depth == capacity) {
+            struct walk_frame *new_stack = realloc(stack, capacity * 2 * sizeof(struct walk_frame));
+            if (new_stack == NULL) {
+                perror("realloc failed");
+                frame->next = frame->subdirectories.count;     // Skip the rest of this directory
+                continue;
+            }
+            stack = new_stack;
+            capacity *= 2;
+            frame = &stack[depth - 1];
+        }
+
+        name = frame->subdirectories.paths[frame->next++];
+        child = &stack[depth];
+        memset(child, 0, sizeof(struct walk_frame));
+        child->dir_fd = -1;
+        child->path = join_path(frame->path, name);
+        if (child->path == NULL) {
+            continue;
+        }
+        if (open_count < walk_fd_budget) {
+            child->dir_fd = frame->dir_fd != -1
+                ? openat(frame->dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+                : open(child->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            open_count += child->dir_fd != -1;
+        }
+        walk_list_directory(child, 1);
+        depth++;
+    }
+    free(stack);
+}
+
+/**
+ * @brief Lists a directory and all directories below it (`-R`).
+ *
+ * Every directory is a task on the work-stealing pool, so large trees are
+ * enumerated and stat'ed on all cores, while the calling thread reassembles
+ * the finished listings in the order a sequential traversal would print them.
+ * With `--depth-first` the tree is instead walked on the calling thread with
+ * memory bounded by its depth.
+ *
+ * @param path Directory at the root of the tree.
+ * @param is_separated Nonzero to print a blank line before the first header.
+ */
+void list_directory_tree(const char *path, int is_separated) {
+    struct dir_node root;
+
+    if (is_depth_first_enabled == 1) {
+        walk_directory_tree(path, is_separated);
+        return;
+    }
+    memset(&root, 0, sizeof(root));
+    root.path = strdup(path);
+    if (root.path == NULL) {
+        perror("strdup failed");
+        return;
+    }
+    pool_group_init(&tree_group);
+    pool_submit(&tree_group, run_directory_task, &root);
+    emit_directory(&root, is_separated);
+    pool_wait(&tree_group);
+    free(root.path);
+}
@@ -0,0 +1,6 @@
+#ifndef ls_recurse
+#define ls_recurse
+
+// Function declarations
+void list_directory_tree(const char *path, int is_separated);
+#endif
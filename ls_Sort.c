@@ -0,0 +1,578 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "ls_Sort.h"
+#include "ls_Pool.h"
+
+#define RADIX_MIN_BUCKET 64             // Buckets smaller than this are finished with qsort
+#define TIME_KEY_BYTES 8                // Bytes of a seconds key, one LSD radix pass each
+#define NSEC_KEY_BYTES 4                // Bytes of a nanoseconds key
+#define PARALLEL_SORT_MIN_TASK 4096     // Fewest elements worth handing to another thread
+
+extern size_t parallel_sort_threshold;  // Entries from which sorting uses the worker pool (0 = never)
+
+// Sort key of one entry, kept next to the entry's position so sorting never touches the entries
+struct sort_item {
+    const unsigned char *key;   // NUL-terminated sort key
+    size_t length;              // Length of the key without its terminator
+    size_t index;               // Position of the entry in the table
+};
+
+// Radix bucket sorted as one pool task
+struct radix_task {
+    struct sort_item *items;    // Items of the bucket
+    struct sort_item *scratch;  // Scratch space for the bucket
+    size_t count;               // Number of items
+    size_t depth;               // Number of leading key bytes the items share
+};
+
+// Entries being copied into their sorted positions
+struct reorder {
+    const struct ls_entry *entries;     // Entries in their original order
+    const struct sort_item *items;      // Sorted items pointing at the original positions
+    struct ls_entry *sorted;            // Destination, in sorted order
+};
+
+// Timestamp keys cut into runs that are sorted concurrently
+struct time_runs {
+    uint64_t *keys;             // Keys to sort
+    size_t *order;              // Payload of every key
+    uint64_t *keys_scratch;     // Scratch space for the keys
+    size_t *order_scratch;      // Scratch space for the payloads
+    size_t count;               // Number of keys
+    size_t run_length;          // Keys per run (the last run may be shorter)
+    int key_bytes;              // Low bytes of the keys that are sorted on
+};
+
+// One pass of merging adjacent sorted runs of timestamp keys
+struct time_merge {
+    const uint64_t *source_keys;    // Runs to merge
+    const size_t *source_order;     // Payloads of the runs
+    uint64_t *target_keys;          // Merged runs
+    size_t *target_order;           // Payloads of the merged runs
+    size_t count;                   // Number of keys
+    size_t width;                   // Length of the runs being merged
+};
+
+/**
+ * @brief Compares the keys of two sort items for qsort.
+ *
+ * @param a Pointer to the first item.
+ * @param b Pointer to the second item.
+ * @return int Negative, zero or positive like strcmp on the keys.
+ */
+static int compare_sort_items(const void *a, const void *b) {
+    const struct sort_item *item1 = a;
+    const struct sort_item *item2 = b;
+    size_t length = item1->length < item2->length ? item1->length : item2->length;
+
+    return memcmp(item1->key, item2->key, length + 1);
+}
+
+/**
+ * @brief Distributes items into 256 buckets by the first key byte where they differ.
+ *
+ * Bytes shared by every item are skipped without moving anything. Bucket 0
+ * holds the keys that end at the distinguishing byte; they are equal, so it
+ * never needs more work.
+ *
+ * @param items Items to distribute; every key is at least `*depth` bytes long.
+ * @param scratch Scratch space for `count` items.
+ * @param count Number of items.
+ * @param depth Number of leading key bytes all items share; advanced past the shared bytes.
+ * @param counts Filled with the number of items per byte value.
+ * @param ends Filled with the position one past every bucket.
+ * @return int 1 if the items were distributed, 0 if all keys are equal.
+ */
+static int radix_partition(struct sort_item *items, struct sort_item *scratch, size_t count, size_t *depth,
+                           size_t counts[256], size_t ends[256]) {
+    size_t position = 0;
+
+    for (;;) {
+        memset(counts, 0, 256 * sizeof(size_t));
+        for (size_t i = 0; i < count; i++) {
+            counts[items[i].key[*depth]]++;
+        }
+        // Every key has the same byte here: move one byte further without distributing
+        if (counts[items[0].key[*depth]] != count) {
+            break;
+        }
+        if (items[0].key[*depth] == '\0') {
+            return 0;     // All keys are equal
+        }
+        (*depth)++;
+    }
+
+    for (int byte = 0; byte < 256; byte++) {
+        ends[byte] = position;
+        position += counts[byte];
+    }
+    for (size_t i = 0; i < count; i++) {
+        scratch[ends[items[i].key[*depth]]++] = items[i];
+    }
+    memcpy(items, scratch, count * sizeof(struct sort_item));
+    return 1;
+}
+
+/**
+ * @brief Sorts items by their keys with a most-significant-digit radix sort.
+ *
+ * The items are distributed into buckets by their first differing key byte
+ * and every bucket is sorted the same way one byte further in. Small buckets
+ * are handed to qsort, where radix passes no longer pay off.
+ *
+ * @param items Items to sort; every key is at least `depth` bytes long.
+ * @param scratch Scratch space for `count` items.
+ * @param count Number of items.
+ * @param depth Number of leading key bytes all items share.
+ */
+static void msd_radix_sort(struct sort_item *items, struct sort_item *scratch, size_t count, size_t depth) {
+    size_t counts[256];     // Items per key byte
+    size_t ends[256];       // Position one past every bucket
+
+    if (count < RADIX_MIN_BUCKET) {
+        qsort(items, count, sizeof(struct sort_item), compare_sort_items);
+        return;
+    }
+    if (radix_partition(items, scratch, count, &depth, counts, ends) == 0) {
+        return;
+    }
+    for (int byte = 1; byte < 256; byte++) {
+        if (counts[byte] > 1) {
+            size_t start = ends[byte] - counts[byte];
+            msd_radix_sort(items + start, scratch + start, counts[byte], depth + 1);
+        }
+    }
+}
+
+/**
+ * @brief Tells whether a sort of `count` elements is worth splitting across the worker pool.
+ *
+ * @param count Number of elements to sort.
+ * @return int 1 to sort in parallel, 0 to sort on the calling thread.
+ */
+static int is_parallel_sort(size_t count) {
+    return parallel_sort_threshold > 0 && count >= parallel_sort_threshold && pool_thread_count() > 1;
+}
+
+static void parallel_msd_radix_sort(struct sort_item *items, struct sort_item *scratch, size_t count, size_t depth);
+
+/**
+ * @brief Sorts one radix bucket as a pool task.
+ *
+ * @param arg The bucket (struct radix_task).
+ */
+static void run_radix_task(void *arg) {
+    struct radix_task *task = arg;
+
+    if (is_parallel_sort(task->count)) {
+        parallel_msd_radix_sort(task->items, task->scratch, task->count, task->depth);
+    } else {
+        msd_radix_sort(task->items, task->scratch, task->count, task->depth);
+    }
+}
+
+/**
+ * @brief MSD radix sort whose buckets are sorted concurrently on the worker pool.
+ *
+ * After one distribution pass the buckets are independent, so every large
+ * bucket becomes a pool task (and is split again if it is still huge) while
+ * the calling thread sorts the small ones.
+ *
+ * @param items Items to sort; every key is at least `depth` bytes long.
+ * @param scratch Scratch space for `count` items.
+ * @param count Number of items.
+ * @param depth Number of leading key bytes all items share.
+ */
+static void parallel_msd_radix_sort(struct sort_item *items, struct sort_item *scratch, size_t count, size_t depth) {
+    size_t counts[256];                 // Items per key byte
+    size_t ends[256];                   // Position one past every bucket
+    struct radix_task tasks[256];       // Buckets handed to the pool
+    struct pool_group group;
+
+    if (radix_partition(items, scratch, count, &depth, counts, ends) == 0) {
+        return;
+    }
+    pool_group_init(&group);
+    for (int byte = 1; byte < 256; byte++) {
+        size_t start = ends[byte] - counts[byte];
+        if (counts[byte] >= PARALLEL_SORT_MIN_TASK) {
+            tasks[byte].items = items + start;
+            tasks[byte].scratch = scratch + start;
+            tasks[byte].count = counts[byte];
+            tasks[byte].depth = depth + 1;
+            pool_submit(&group, run_radix_task, &tasks[byte]);
+        }
+    }
+    for (int byte = 1; byte < 256; byte++) {
+        if (counts[byte] > 1 && counts[byte] < PARALLEL_SORT_MIN_TASK) {
+            size_t start = ends[byte] - counts[byte];
+            msd_radix_sort(items + start, scratch + start, counts[byte], depth + 1);
+        }
+    }
+    pool_wait(&group);
+}
+
+/**
+ * @brief Sorts items by their keys, on the worker pool when there are enough of them.
+ *
+ * @param items Items to sort.
+ * @param scratch Scratch space for `count` items.
+ * @param count Number of items.
+ */
+static void sort_items(struct sort_item *items, struct sort_item *scratch, size_t count) {
+    if (is_parallel_sort(count)) {
+        parallel_msd_radix_sort(items, scratch, count, 0);
+    } else {
+        msd_radix_sort(items, scratch, count, 0);
+    }
+}
+
+/**
+ * @brief Copies a range of entries into their sorted positions.
+ *
+ * @param begin First sorted position to fill.
+ * @param end One past the last sorted position to fill.
+ * @param arg The reordering (struct reorder).
+ */
+static void reorder_range(size_t begin, size_t end, void *arg) {
+    const struct reorder *reorder = arg;
+
+    for (size_t i = begin; i < end; i++) {
+        reorder->sorted[i] = reorder->entries[reorder->items[i].index];
+    }
+}
+
+/**
+ * @brief Moves the entries of a table into the order given by sorted items.
+ *
+ * Large tables are copied by several threads at once.
+ *
+ * @param table Table to reorder.
+ * @param items One item per entry, in the wanted order.
+ * @param sorted Space for `table->capacity` entries; it becomes the table's entry vector.
+ */
+static void reorder_entries(struct ls_entry_table *table, const struct sort_item *items, struct ls_entry *sorted) {
+    struct reorder reorder = { table->entries, items, sorted };
+
+    if (is_parallel_sort(table->count)) {
+        pool_parallel_for(table->count, PARALLEL_SORT_MIN_TASK, reorder_range, &reorder);
+    } else {
+        reorder_range(0, table->count, &reorder);
+    }
+    free(table->entries);
+    table->entries = sorted;
+}
+
+/**
+ * @brief Sorts the entries of a table by their prepared sort keys.
+ *
+ * The keys (see `entry_table_prepare_sort_keys`) are sorted as compact items
+ * holding a key pointer and the entry position, so the radix passes stream
+ * through one small array instead of chasing entry records; the entries are
+ * then moved into their final order once. Entries with equal keys end up in
+ * an unspecified order, as with qsort.
+ *
+ * @param table Table whose entries all have sort keys.
+ * @return int 0 on success, -1 on allocation failure (the table is left unsorted).
+ */
+int radix_sort_entries(struct ls_entry_table *table) {
+    struct sort_item *items;            // Keys being sorted
+    struct sort_item *scratch;          // Scratch space for the radix passes
+    struct ls_entry *sorted;            // Entries in their final order
+
+    if (table->count < 2) {
+        return 0;
+    }
+    items = malloc(table->count * sizeof(struct sort_item));
+    scratch = malloc(table->count * sizeof(struct sort_item));
+    sorted = malloc(table->capacity * sizeof(struct ls_entry));
+    if (items == NULL || scratch == NULL || sorted == NULL) {
+        perror("malloc failed");
+        free(items);
+        free(scratch);
+        free(sorted);
+        return -1;
+    }
+
+    for (size_t i = 0; i < table->count; i++) {
+        items[i].key = (const unsigned char *)table->entries[i].sort_key;
+        items[i].length = table->entries[i].sort_key_length;
+        items[i].index = i;
+    }
+    sort_items(items, scratch, table->count);
+    reorder_entries(table, items, sorted);
+
+    free(items);
+    free(scratch);
+    return 0;
+}
+
+/**
+ * @brief Packs the seconds of a timestamp into an unsigned key that sorts newest first.
+ *
+ * The sign bit is flipped so the key orders like the signed value, and the
+ * result is inverted so ascending keys mean descending times. Seconds are
+ * kept apart from nanoseconds, so every representable time has a key;
+ * combining them into one nanosecond count overflows before 1677 and after 2262.
+ *
+ * @param time Timestamp to pack.
+ * @return uint64_t The key.
+ */
+static uint64_t newest_first_seconds_key(const struct timespec *time) {
+    return ~((uint64_t)(int64_t)time->tv_sec ^ (UINT64_C(1) << 63));
+}
+
+/**
+ * @brief Packs the nanoseconds of a timestamp into a 4-byte key that sorts newest first.
+ *
+ * @param time Timestamp to pack.
+ * @return uint64_t The key.
+ */
+static uint64_t newest_first_nanoseconds_key(const struct timespec *time) {
+    return UINT32_MAX - (uint32_t)time->tv_nsec;
+}
+
+/**
+ * @brief Stable least-significant-digit radix sort of 64-bit keys and their payloads.
+ *
+ * Only the low `key_bytes` bytes of the keys are sorted on. Their histograms
+ * are built in one pass; passes whose byte is the same for every key are skipped.
+ *
+ * @param keys Keys to sort (struct-of-arrays with `order`).
+ * @param order Payload moved along with every key.
+ * @param keys_scratch Scratch space for `count` keys.
+ * @param order_scratch Scratch space for `count` payloads.
+ * @param count Number of keys.
+ * @param key_bytes Number of low key bytes to sort on (at most TIME_KEY_BYTES).
+ * @return int 1 if the sorted data ended up in the scratch arrays, 0 if it is in `keys`/`order`.
+ */
+static int lsd_radix_sort(uint64_t *keys, size_t *order, uint64_t *keys_scratch, size_t *order_scratch, size_t count,
+                          int key_bytes) {
+    size_t counts[TIME_KEY_BYTES][256];     // Keys per byte value, for every byte position
+    int in_scratch = 0;                     // Which buffer holds the current order
+
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < count; i++) {
+        for (int pass = 0; pass < key_bytes; pass++) {
+            counts[pass][(keys[i] >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    for (int pass = 0; pass < key_bytes; pass++) {
+        unsigned int shift = pass * 8;
+        uint64_t *source_keys = in_scratch ? keys_scratch : keys;
+        size_t *source_order = in_scratch ? order_scratch : order;
+        uint64_t *target_keys = in_scratch ? keys : keys_scratch;
+        size_t *target_order = in_scratch ? order : order_scratch;
+        size_t offsets[256];
+        size_t position = 0;
+
+        if (counts[pass][(source_keys[0] >> shift) & 0xff] == count) {
+            continue;   // Every key has the same byte here
+        }
+        for (int byte = 0; byte < 256; byte++) {
+            offsets[byte] = position;
+            position += counts[pass][byte];
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t target = offsets[(source_keys[i] >> shift) & 0xff]++;
+            target_keys[target] = source_keys[i];
+            target_order[target] = source_order[i];
+        }
+        in_scratch = !in_scratch;
+    }
+    return in_scratch;
+}
+
+/**
+ * @brief Sorts a range of runs of timestamp keys, each with the LSD radix sort.
+ *
+ * @param begin First run to sort.
+ * @param end One past the last run to sort.
+ * @param arg The keys being sorted (struct time_runs).
+ */
+static void sort_time_runs(size_t begin, size_t end, void *arg) {
+    const struct time_runs *runs = arg;
+
+    for (size_t run = begin; run < end; run++) {
+        size_t start = run * runs->run_length;
+        size_t length;
+
+        if (start >= runs->count) {
+            break;  // Past the last (possibly shorter) run
+        }
+        length = runs->count - start < runs->run_length ? runs->count - start : runs->run_length;
+
+        if (lsd_radix_sort(runs->keys + start, runs->order + start, runs->keys_scratch + start,
+                           runs->order_scratch + start, length, runs->key_bytes)) {
+            memcpy(runs->keys + start, runs->keys_scratch + start, length * sizeof(uint64_t));
+            memcpy(runs->order + start, runs->order_scratch + start, length * sizeof(size_t));
+        }
+    }
+}
+
+/**
+ * @brief Merges a range of pairs of adjacent sorted runs, keeping equal keys in order.
+ *
+ * @param begin First pair to merge.
+ * @param end One past the last pair to merge.
+ * @param arg The merge pass (struct time_merge).
+ */
+static void merge_time_runs(size_t begin, size_t end, void *arg) {
+    const struct time_merge *merge = arg;
+
+    for (size_t pair = begin; pair < end; pair++) {
+        size_t left = pair * 2 * merge->width;
+        size_t middle, right, i, j, out;
+
+        if (left >= merge->count) {
+            break;  // Past the last (possibly partial) pair
+        }
+        middle = left + merge->width < merge->count ? left + merge->width : merge->count;
+        right = middle + merge->width < merge->count ? middle + merge->width : merge->count;
+        i = left;
+        j = middle;
+        out = left;
+
+        while (i < middle && j < right) {
+            // Ties take the left run first, which keeps the sort stable
+            size_t from = merge->source_keys[j] < merge->source_keys[i] ? j++ : i++;
+            merge->target_keys[out] = merge->source_keys[from];
+            merge->target_order[out++] = merge->source_order[from];
+        }
+        while (i < middle) {
+            merge->target_keys[out] = merge->source_keys[i];
+            merge->target_order[out++] = merge->source_order[i++];
+        }
+        while (j < right) {
+            merge->target_keys[out] = merge->source_keys[j];
+            merge->target_order[out++] = merge->source_order[j++];
+        }
+    }
+}
+
+/**
+ * @brief Stable sort of timestamp keys and their payloads, on the worker pool when large.
+ *
+ * Large inputs are cut into one run per thread, the runs are radix sorted
+ * concurrently, and adjacent runs are then merged pairwise, every merge of a
+ * pass running as its own task, until one run is left.
+ *
+ * @param keys Keys to sort.
+ * @param order Payload moved along with every key.
+ * @param keys_scratch Scratch space for `count` keys.
+ * @param order_scratch Scratch space for `count` payloads.
+ * @param count Number of keys.
+ * @param key_bytes Number of low key bytes to sort on.
+ * @return size_t* The array holding the sorted payloads (`order` or `order_scratch`).
+ */
+static size_t *sort_time_keys(uint64_t *keys, size_t *order, uint64_t *keys_scratch, size_t *order_scratch, size_t count,
+                              int key_bytes) {
+    size_t threads = pool_thread_count();
+    struct time_runs runs = { keys, order, keys_scratch, order_scratch, count, 0, key_bytes };
+    struct time_merge merge;
+    int in_scratch = 0;     // Which buffer holds the current runs
+
+    if (!is_parallel_sort(count)) {
+        return lsd_radix_sort(keys, order, keys_scratch, order_scratch, count, key_bytes) ? order_scratch : order;
+    }
+
+    // The last run may be shorter, and small inputs may need fewer runs than there are threads
+    runs.run_length = (count + threads - 1) / threads;
+    pool_parallel_for((count + runs.run_length - 1) / runs.run_length, 1, sort_time_runs, &runs);
+
+    merge.count = count;
+    for (merge.width = runs.run_length; merge.width < count; merge.width *= 2) {
+        merge.source_keys = in_scratch ? keys_scratch : keys;
+        merge.source_order = in_scratch ? order_scratch : order;
+        merge.target_keys = in_scratch ? keys : keys_scratch;
+        merge.target_order = in_scratch ? order : order_scratch;
+        pool_parallel_for((count + 2 * merge.width - 1) / (2 * merge.width), 1, merge_time_runs, &merge);
+        in_scratch = !in_scratch;
+    }
+    return in_scratch ? order_scratch : order;
+}
+
+/**
+ * @brief Sorts the entries of a table newest first, breaking ties by name.
+ *
+ * The entries are first put in name order (strcmp order, with the MSD radix
+ * sort over the names). Their timestamps are then sorted with two stable
+ * LSD radix sorts, first on 4-byte nanosecond keys and then on 8-byte
+ * second keys, kept in a separate array next to the entry positions, so
+ * entries with the same time stay in name order. The whole sort is linear
+ * in the number of entries.
+ *
+ * @param table Table whose entries have their timestamps loaded.
+ * @param by_change_time Nonzero to sort by status change time, zero for modification time.
+ * @return int 0 on success, -1 on allocation failure (the table is left unsorted).
+ */
+int radix_sort_entries_by_time(struct ls_entry_table *table, int by_change_time) {
+    size_t count = table->count;
+    struct sort_item *items;            // Entries in name order, then in final order
+    struct sort_item *scratch;          // Scratch space for the name sort
+    uint64_t *keys;                     // Packed timestamps
+    uint64_t *keys_scratch;
+    size_t *order;                      // Entry position of every key
+    size_t *order_scratch;
+    struct ls_entry *sorted;            // Entries in their final order
+    size_t *result;                     // Array holding the sorted positions
+    int status = -1;
+
+    if (count < 2) {
+        return 0;
+    }
+    items = malloc(count * sizeof(struct sort_item));
+    scratch = malloc(count * sizeof(struct sort_item));
+    keys = malloc(count * sizeof(uint64_t));
+    keys_scratch = malloc(count * sizeof(uint64_t));
+    order = malloc(count * sizeof(size_t));
+    order_scratch = malloc(count * sizeof(size_t));
+    sorted = malloc(table->capacity * sizeof(struct ls_entry));
+    if (items == NULL || scratch == NULL || keys == NULL || keys_scratch == NULL ||
+        order == NULL || order_scratch == NULL || sorted == NULL) {
+        perror("malloc failed");
+        free(sorted);
+    } else {
+        // Name order first, so the stable time sort leaves equal times sorted by name
+        for (size_t i = 0; i < count; i++) {
+            items[i].key = (const unsigned char *)table->entries[i].name;
+            items[i].length = strlen(table->entries[i].name);
+            items[i].index = i;
+        }
+        sort_items(items, scratch, count);
+
+        // Nanoseconds first, then seconds: the second stable pass leaves equal seconds in nanosecond order
+        for (size_t i = 0; i < count; i++) {
+            const struct ls_entry *entry = &table->entries[items[i].index];
+            keys[i] = newest_first_nanoseconds_key(by_change_time ? &entry->ctime : &entry->mtime);
+            order[i] = items[i].index;
+        }
+        result = sort_time_keys(keys, order, keys_scratch, order_scratch, count, NSEC_KEY_BYTES);
+        for (size_t i = 0; i < count; i++) {
+            items[i].index = result[i];
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const struct ls_entry *entry = &table->entries[items[i].index];
+            keys[i] = newest_first_seconds_key(by_change_time ? &entry->ctime : &entry->mtime);
+            order[i] = items[i].index;
+        }
+        result = sort_time_keys(keys, order, keys_scratch, order_scratch, count, TIME_KEY_BYTES);
+        for (size_t i = 0; i < count; i++) {
+            items[i].index = result[i];
+        }
+        reorder_entries(table, items, sorted);
+        status = 0;
+    }
+
+    free(items);
+    free(scratch);
+    free(keys);
+    free(keys_scratch);
+    free(order);
+    free(order_scratch);
+    return status;
+}
@@ -0,0 +1,8 @@
+#ifndef ls_sort
+#define ls_sort
+#include "ls_Functions.h"
+
+// Function declarations
+int radix_sort_entries(struct ls_entry_table *table);
+int radix_sort_entries_by_time(struct ls_entry_table *table, int by_change_time);
+#endif
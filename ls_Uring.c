@@ -0,0 +1,303 @@
+#define _GNU_SOURCE // For statx
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "ls_Uring.h"
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// IORING_OP_STATX is an enum constant; the probe macro was introduced alongside it (Linux 5.6)
+#if defined(IO_URING_OP_SUPPORTED) && defined(__NR_io_uring_setup)
+
+#define URING_QUEUE_DEPTH 256   // Statx requests kept in flight at once
+#define URING_MAX_REFUSALS 64   // EAGAIN/EBUSY answers in a row before falling back to statx calls
+
+// Memory-mapped submission and completion rings of one io_uring instance
+struct uring {
+    int fd;                         // io_uring file descriptor
+    unsigned int *sq_head;          // Submission queue head (advanced by the kernel)
+    unsigned int *sq_tail;          // Submission queue tail (advanced by us)
+    unsigned int *sq_mask;          // Submission queue index mask
+    unsigned int *sq_array;         // Submission queue index array
+    struct io_uring_sqe *sqes;      // Submission queue entries
+    unsigned int *cq_head;          // Completion queue head (advanced by us)
+    unsigned int *cq_tail;          // Completion queue tail (advanced by the kernel)
+    unsigned int *cq_mask;          // Completion queue index mask
+    struct io_uring_cqe *cqes;      // Completion queue entries
+    unsigned int depth;             // Number of submission queue entries
+};
+
+// One in-flight statx request
+struct uring_slot {
+    struct statx result;            // Buffer the kernel fills
+    size_t entry_index;             // Entry of the table the request belongs to
+};
+
+// Each thread lazily sets up its own ring, so concurrent listings never share one
+static __thread struct uring thread_ring;
+static __thread int thread_ring_state = 0;     // 0 = not tried yet, 1 = ready, -1 = unavailable
+
+/**
+ * @brief Checks whether the kernel behind a ring supports IORING_OP_STATX.
+ *
+ * @param ring_fd io_uring file descriptor.
+ * @return int 1 if statx requests are supported, 0 otherwise.
+ */
+static int uring_supports_statx(int ring_fd) {
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, probe_size);
+    int supported = 0;
+
+    if (probe == NULL) {
+        return 0;
+    }
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+        supported = probe->last_op >= IORING_OP_STATX &&
+                    (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return supported;
+}
+
+/**
+ * @brief Creates an io_uring instance and maps its rings.
+ *
+ * @param ring Ring to set up.
+ * @return int 0 on success, -1 if io_uring or its statx operation is unavailable.
+ */
+static int uring_setup(struct uring *ring) {
+    struct io_uring_params params;  // Parameters negotiated with the kernel
+    size_t sq_ring_size, cq_ring_size;
+    char *sq_ring, *cq_ring;        // Mapped ring memory
+    void *sqes;
+
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, URING_QUEUE_DEPTH, &params);
+    if (ring->fd == -1) {
+        return -1;
+    }
+    if (!uring_supports_statx(ring->fd)) {
+        close(ring->fd);
+        return -1;
+    }
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        // Both rings live in one mapping
+        if (cq_ring_size > sq_ring_size) {
+            sq_ring_size = cq_ring_size;
+        }
+        cq_ring_size = sq_ring_size;
+    }
+
+    sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring->fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ring = sq_ring;
+    } else {
+        cq_ring = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring->fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED) {
+            munmap(sq_ring, sq_ring_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+    sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq_ring != sq_ring) {
+            munmap(cq_ring, cq_ring_size);
+        }
+        munmap(sq_ring, sq_ring_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_head = (unsigned int *)(sq_ring + params.sq_off.head);
+    ring->sq_tail = (unsigned int *)(sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned int *)(sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned int *)(sq_ring + params.sq_off.array);
+    ring->sqes = sqes;
+    ring->cq_head = (unsigned int *)(cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned int *)(cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned int *)(cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+    ring->depth = params.sq_entries;
+    return 0;
+}
+
+/**
+ * @brief Returns the calling thread's ring, setting it up on first use.
+ *
+ * @return struct uring* The ring, or NULL if io_uring cannot be used.
+ */
+static struct uring *uring_get(void) {
+    if (thread_ring_state == 0) {
+        thread_ring_state = uring_setup(&thread_ring) == 0 ? 1 : -1;
+    }
+    return thread_ring_state == 1 ? &thread_ring : NULL;
+}
+
+/**
+ * @brief Queues one statx request on the submission ring.
+ *
+ * @param ring Ring to queue on.
+ * @param dir_fd Directory the name is relative to.
+ * @param name Name to stat.
+ * @param mask STATX_* fields to request.
+ * @param flags AT_* flags for statx.
+ * @param slot_index Slot receiving the result, returned in the completion.
+ * @param slot Slot whose buffer the kernel fills.
+ */
+static void uring_queue_statx(struct uring *ring, int dir_fd, const char *name, unsigned int mask,
+                              int flags, unsigned int slot_index, struct uring_slot *slot) {
+    unsigned int tail = *ring->sq_tail;                 // Only this thread moves the tail
+    unsigned int index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = dir_fd;
+    sqe->addr = (uint64_t)(uintptr_t)name;
+    sqe->len = mask;
+    sqe->off = (uint64_t)(uintptr_t)&slot->result;
+    sqe->statx_flags = (uint32_t)flags;
+    sqe->user_data = slot_index;
+    ring->sq_array[index] = index;
+
+    // Publish the entry before the kernel can see the new tail
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Loads the metadata of every entry in a table with batched io_uring statx requests.
+ *
+ * Up to URING_QUEUE_DEPTH requests are kept in flight; each system call both
+ * submits new requests and reaps finished ones. Requests the kernel does not
+ * take stay queued and are submitted again. Entries whose statx fails are
+ * reported and left with `is_loaded` cleared so the caller can drop them.
+ *
+ * @param table Table whose entries are loaded relative to its `dir_fd`.
+ * @param mask STATX_* fields to request.
+ * @param flags AT_* flags for statx.
+ * @return int 0 if every request was processed, -1 if io_uring is unavailable or
+ *         failed (the caller should then load the whole table synchronously).
+ */
+int uring_load_table_metadata(struct ls_entry_table *table, unsigned int mask, int flags) {
+    struct uring *ring = uring_get();
+    struct uring_slot *slots;           // Buffers of the in-flight requests
+    unsigned int *free_slots;           // Stack of unused slot indices
+    unsigned int free_count;            // Number of unused slots
+    unsigned int to_submit = 0;         // Requests queued but not taken by the kernel yet
+    unsigned int in_flight;             // Requests taken by the kernel and not completed yet
+    long submitted;                     // Requests taken by the last io_uring_enter, or -1
+    size_t next_entry = 0;              // Next entry to queue
+    size_t completed = 0;               // Requests completed so far
+    unsigned int refused = 0;           // io_uring_enter calls refused in a row (EAGAIN/EBUSY)
+
+    if (ring == NULL) {
+        return -1;
+    }
+    slots = malloc(ring->depth * sizeof(struct uring_slot));
+    free_slots = malloc(ring->depth * sizeof(unsigned int));
+    if (slots == NULL || free_slots == NULL) {
+        free(slots);
+        free(free_slots);
+        return -1;
+    }
+    for (free_count = 0; free_count < ring->depth; free_count++) {
+        free_slots[free_count] = free_count;
+    }
+
+    while (completed < table->count) {
+        unsigned int head, tail;        // Completion queue bounds
+
+        // Fill every free slot with the next entries
+        while (free_count > 0 && next_entry < table->count) {
+            unsigned int slot_index = free_slots[--free_count];
+            slots[slot_index].entry_index = next_entry;
+            uring_queue_statx(ring, table->dir_fd, table->entries[next_entry].name, mask, flags,
+                              slot_index, &slots[slot_index]);
+            next_entry++;
+            to_submit++;
+        }
+
+        // Submit what was queued. Wait for a completion only while one is outstanding: the
+        // kernel may take just part of the queue, and waiting on nothing never returns
+        in_flight = (unsigned int)(next_entry - completed) - to_submit;
+        submitted = syscall(__NR_io_uring_enter, ring->fd, to_submit, in_flight > 0 ? 1 : 0,
+                            in_flight > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted == -1 && errno == EINTR) {
+            continue;
+        }
+        if (submitted > 0 || (submitted == 0 && in_flight > 0)) {
+            // Whatever the kernel did not take stays queued and is submitted next time
+            to_submit -= (unsigned int)submitted;
+            refused = 0;
+        } else if ((submitted == -1 && errno != EAGAIN && errno != EBUSY) || ++refused > URING_MAX_REFUSALS) {
+            // A refusal (short of resources, completion queue full) or a submit that took
+            // nothing is retried after reaping what has completed, but not indefinitely.
+            // Requests may still be in flight, so their buffers are deliberately not freed
+            // and the ring is retired; the caller reloads everything synchronously
+            thread_ring_state = -1;
+            return -1;
+        }
+
+        // Reap every available completion
+        head = *ring->cq_head;
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            unsigned int slot_index = (unsigned int)cqe->user_data;
+            struct ls_entry *entry = &table->entries[slots[slot_index].entry_index];
+
+            if (cqe->res < 0) {
+                fprintf(stderr, "stat failed: %s\n", strerror(-cqe->res));
+            } else {
+                fill_entry_from_statx(entry, &slots[slot_index].result);
+                entry->is_loaded = 1;
+            }
+            free_slots[free_count++] = slot_index;
+            completed++;
+            head++;
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    free(slots);
+    free(free_slots);
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Fallback when the system headers do not provide io_uring statx.
+ *
+ * @return int Always -1, so the caller loads metadata synchronously.
+ */
+int uring_load_table_metadata(struct ls_entry_table *table, unsigned int mask, int flags) {
+    (void)table;
+    (void)mask;
+    (void)flags;
+    return -1;
+}
+
+#endif
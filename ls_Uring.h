@@ -0,0 +1,7 @@
+#ifndef ls_uring
+#define ls_uring
+#include "ls_Functions.h"
+
+// Function declarations
+int uring_load_table_metadata(struct ls_entry_table *table, unsigned int mask, int flags);
+#endif
@@ -3,14 +3,56 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 #include <stdint.h>
 #include <libgen.h>
+#include <locale.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include "ls_Functions.h" // Header file for function declarations
+#include "ls_Output.h"    // Buffered standard output
+#include "ls_Recurse.h"   // Recursive listing (-R)
+#include "ls_Pool.h"      // Worker pool
+#include "ls_Layout.h"    // Column layout of the default listing
 
 #define MAX_ARGS 2500 // Maximum number of command-line arguments
+#define DEFAULT_DIRENT_BUFFER_SIZE (1024 * 1024) // getdents64 buffer used per directory
+#define MIN_DIRENT_BUFFER_SIZE 4096              // Smallest buffer that always fits a record
+#define DEFAULT_PARALLEL_SORT_THRESHOLD 100000   // Entries from which sorting is split across threads
+#define DEFAULT_WALK_FD_BUDGET 256               // Directory descriptors a depth-first walk keeps open
 
-extern char *dir;                               
+// Values returned by getopt_long for the tuning options, outside the range of short options
+enum {
+    OPT_DIRENT_BUFFER = 256,   // --dirent-buffer=SIZE
+    OPT_NO_SYNC,               // --no-sync
+    OPT_NO_IO_URING,           // --no-io-uring
+    OPT_THREADS,               // --threads=N
+    OPT_COLLATE,               // --collate
+    OPT_SORT_ENGINE,           // --sort-engine=radix|qsort
+    OPT_PARALLEL_SORT_THRESHOLD, // --parallel-sort-threshold=N
+    OPT_TOP,                   // --top=N
+    OPT_BOTTOM,                // --bottom=N
+    OPT_DEPTH_FIRST,           // --depth-first
+    OPT_FD_BUDGET              // --fd-budget=N
+};
+
+// Long options that tune the listing engine without changing what is listed
+static const struct option long_options[] = {
+    {"dirent-buffer", required_argument, NULL, OPT_DIRENT_BUFFER},
+    {"no-sync", no_argument, NULL, OPT_NO_SYNC},
+    {"no-io-uring", no_argument, NULL, OPT_NO_IO_URING},
+    {"threads", required_argument, NULL, OPT_THREADS},
+    {"collate", no_argument, NULL, OPT_COLLATE},
+    {"sort-engine", required_argument, NULL, OPT_SORT_ENGINE},
+    {"parallel-sort-threshold", required_argument, NULL, OPT_PARALLEL_SORT_THRESHOLD},
+    {"top", required_argument, NULL, OPT_TOP},
+    {"bottom", required_argument, NULL, OPT_BOTTOM},
+    {"depth-first", no_argument, NULL, OPT_DEPTH_FIRST},
+    {"fd-budget", required_argument, NULL, OPT_FD_BUDGET},
+    {NULL, 0, NULL, 0}
+};
 
 // Global flags for command-line options
 uint8_t is_long_format_enabled = 0;      // Flag for long format output
@@ -23,24 +65,159 @@ uint8_t is_ctime_option_enabled = 0;     // Flag to indicate sorting by change t
 uint8_t is_no_sort_enabled = 0;          // Flag to disable sorting
 uint8_t is_inode_enabled = 0;             // Flag to display inode numbers
 uint8_t is_column_output_enabled = 0;     // Flag for column output format
+uint8_t is_recursive_enabled = 0;         // Flag to list subdirectories recursively
+
+// Tuning parameters for the listing engine
+uint8_t is_dont_sync_enabled = 0;         // Flag to let statx answer from cached attributes
+uint8_t is_io_uring_enabled = 1;          // Flag to allow batched metadata loads through io_uring
+uint8_t is_collate_enabled = 0;           // Flag to sort names by the LC_COLLATE locale instead of folded bytes
+uint8_t is_radix_sort_enabled = 1;        // Flag to sort names with the radix sort engine instead of qsort
+size_t worker_thread_count = 0;           // Threads in the worker pool (0 = number of online CPUs)
+size_t dirent_buffer_size = DEFAULT_DIRENT_BUFFER_SIZE; // Size of the getdents64 buffer in bytes
+size_t parallel_sort_threshold = DEFAULT_PARALLEL_SORT_THRESHOLD; // Entries from which sorting uses the worker pool (0 = never)
+size_t top_entry_count = 0;               // Entries kept by --top/--bottom (0 = list everything)
+uint8_t is_bottom_enabled = 0;            // Flag to keep the oldest entries (--bottom) instead of the newest
+uint8_t is_depth_first_enabled = 0;       // Flag to walk -R trees depth-first on one thread with bounded memory
+size_t walk_fd_budget = DEFAULT_WALK_FD_BUDGET; // Directory descriptors a depth-first walk keeps open
+size_t output_line_width = 80;            // Width of the line the default listing fills with columns
+
+// Arguments of sort_and_display being classified and listed on the worker pool
+struct argument_batch {
+    char **paths;               // Arguments
+    uint8_t *is_dir;            // Set for every argument that is a directory
+    struct out_buf *outputs;    // Listing of every argument a worker rendered ahead of the output
+    uint8_t *states;            // ARGUMENT_* state of every argument (accessed atomically)
+    pthread_mutex_t lock;       // Protects the wait for ARGUMENT_RENDERED
+    pthread_cond_t rendered;    // Broadcast when a worker finishes an argument
+};
+
+// Listing of one argument of an argument_batch (a pool task)
+struct argument_task {
+    struct argument_batch *batch;
+    size_t index;               // Position of the argument in output order
+};
+
+#define ARGUMENT_PENDING 0      // Nobody has started listing the argument
+#define ARGUMENT_RENDERING 1    // A worker is listing it into its buffer
+#define ARGUMENT_RENDERED 2     // Its buffer is complete
+#define ARGUMENT_STREAMING 3    // The emitting thread lists it straight to the output
+
+// Function to parse a size argument with an optional K or M suffix
+int parse_size(const char *text, size_t *size) {
+    char *end;                                        // First character after the number
+    unsigned long long value;
+    unsigned long long multiplier = 1;                // Value of the K or M suffix
+
+    if (*text < '0' || *text > '9') {
+        return -1; // No digits at all, or a sign strtoull would quietly accept
+    }
+    errno = 0;
+    value = strtoull(text, &end, 10);
+    if (errno == ERANGE) {
+        return -1; // Too large to represent
+    }
+    if (*end == 'K' || *end == 'k') {
+        multiplier = 1024;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        multiplier = 1024 * 1024;
+        end++;
+    }
+    if (*end != '\0') {
+        return -1; // Trailing garbage
+    }
+    if (value > SIZE_MAX / multiplier) {
+        return -1; // The suffix would overflow the size
+    }
+    value *= multiplier;
+    *size = (size_t)value;
+    return 0;
+}
 
 // Function to check if the provided path is a directory
 int is_directory(const char *file_path) {
     struct stat file_stat; // Structure to hold file status information
-    stat(file_path, &file_stat); // Get the status of the file at the provided path
+    if (stat(file_path, &file_stat) == -1) { // Get the status of the file at the provided path
+        return 0; // Missing paths are reported by the listing itself
+    }
     return S_ISDIR(file_stat.st_mode); // Return 1 if it is a directory, 0 otherwise
 }
 
+// Function to classify a range of arguments as directories or files (run on the worker pool)
+static void classify_arguments(size_t begin, size_t end, void *arg) {
+    struct argument_batch *batch = arg;
+    for (size_t i = begin; i < end; i++) {
+        batch->is_dir[i] = (uint8_t)is_directory(batch->paths[i]);
+    }
+}
+
+// Function to list one argument to out_current; file operands of -l and recursive listings are handled by the caller
+static void list_argument(const char *path) {
+    if (is_long_format_enabled == 1) {
+        list_directory_long_format((char *)path); // Long format display
+    } else if (is_no_option_enabled == 1 || is_hidden_files_enabled == 1) {
+        do_ls((char *)path); // Standard display
+    }
+}
+
+// Function to list an argument into its buffer ahead of the output, unless the output already reached it (pool task)
+static void render_argument_ahead(void *arg) {
+    struct argument_task *task = arg;
+    struct argument_batch *batch = task->batch;
+    struct out_buf *previous_out = out_current;
+    uint8_t expected = ARGUMENT_PENDING;
+
+    if (!__atomic_compare_exchange_n(&batch->states[task->index], &expected, ARGUMENT_RENDERING,
+                                     0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return; // Already being streamed by the emitting thread
+    }
+    out_init(&batch->outputs[task->index], -1);
+    out_current = &batch->outputs[task->index];
+    list_argument(batch->paths[task->index]);
+    out_current = previous_out;
+
+    pthread_mutex_lock(&batch->lock);
+    __atomic_store_n(&batch->states[task->index], ARGUMENT_RENDERED, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&batch->rendered);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+// Function to print one argument: stream it if no worker started it, otherwise copy the buffer it was rendered into
+static void emit_argument(struct argument_batch *batch, size_t index) {
+    uint8_t expected = ARGUMENT_PENDING;
+
+    if (__atomic_compare_exchange_n(&batch->states[index], &expected, ARGUMENT_STREAMING,
+                                    0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        list_argument(batch->paths[index]);
+        return;
+    }
+    pthread_mutex_lock(&batch->lock);
+    while (__atomic_load_n(&batch->states[index], __ATOMIC_ACQUIRE) != ARGUMENT_RENDERED) {
+        pthread_cond_wait(&batch->rendered, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+    out_write(out_current, batch->outputs[index].data, batch->outputs[index].length);
+    out_free(&batch->outputs[index]);
+}
+
 // Function to sort and display files and directories
 void sort_and_display(char *file_paths[], int argument_count) {
     char *regular_files[MAX_ARGS];      // Array to hold regular file paths
     char *directories[MAX_ARGS];        // Array to hold directory paths
     int regular_file_count = 0;         // Counter for regular files
     int directory_count = 0;            // Counter for directories
+    char *ordered_paths[MAX_ARGS];      // Regular files, then directories, in output order
+    uint8_t is_dir[MAX_ARGS];           // Classification of every argument
+    uint8_t states[MAX_ARGS] = { 0 };   // ARGUMENT_* state of every argument, in output order
+    struct argument_task tasks[MAX_ARGS];
+    struct argument_batch batch = { file_paths, is_dir, NULL, states,
+                                    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+    struct pool_group group;
 
-    // Separate regular files and directories
+    // Separate regular files and directories, stat'ing the arguments concurrently
+    pool_parallel_for(argument_count, 1, classify_arguments, &batch);
     for (int i = 0; i < argument_count; i++) {
-        if (is_directory(file_paths[i])) {
+        if (is_dir[i]) {
             directories[directory_count++] = file_paths[i]; // Store directory path
         } else {
             regular_files[regular_file_count++] = file_paths[i]; // Store regular file path
@@ -51,31 +228,66 @@ void sort_and_display(char *file_paths[], int argument_count) {
     qsort(regular_files, regular_file_count, sizeof(char *), compare);
     qsort(directories, directory_count, sizeof(char *), compare);
 
-    // Print regular files first
     for (int i = 0; i < regular_file_count; i++) {
-        if (is_long_format_enabled == 1) {
-            list_directory_long_format(regular_files[i]); // Long format display
-        } else if (is_no_option_enabled == 1 || is_hidden_files_enabled == 1) {
-            do_ls(regular_files[i]); // Standard display
+        ordered_paths[i] = regular_files[i];
+        is_dir[i] = 0;
+    }
+    for (int i = 0; i < directory_count; i++) {
+        ordered_paths[regular_file_count + i] = directories[i];
+        is_dir[regular_file_count + i] = 1;
+    }
+    batch.paths = ordered_paths;
+
+    // Let workers list later arguments ahead of the output while this thread streams the
+    // one at its head. A lone argument, an unsorted (-f) listing or a single thread has
+    // nothing to overlap, so every argument streams straight to the output
+    pool_group_init(&group);
+    if (argument_count > 1 && is_no_sort_enabled == 0 && pool_thread_count() > 1) {
+        batch.outputs = malloc(argument_count * sizeof(struct out_buf));
+        if (batch.outputs == NULL) {
+            perror("malloc failed");
+            return;
+        }
+        for (int i = 1; i < argument_count; i++) {
+            // Recursive listings reassemble their own output, and long format file operands
+            // are printed together so their columns line up
+            if ((is_dir[i] == 1 && is_recursive_enabled == 1) || (is_dir[i] == 0 && is_long_format_enabled == 1)) {
+                continue;
+            }
+            tasks[i].batch = &batch;
+            tasks[i].index = i;
+            pool_submit(&group, render_argument_ahead, &tasks[i]);
+        }
+    }
+
+    // Print regular files first
+    if (is_long_format_enabled == 1 && regular_file_count > 0) {
+        list_paths_long_format(regular_files, regular_file_count);
+    } else {
+        for (int i = 0; i < regular_file_count; i++) {
+            emit_argument(&batch, i);
         }
     }
 
     // Print directories after regular files
     for (int i = 0; i < directory_count; i++) {
-        dir = directories[i] ;
+        // A recursive listing prints a header for every directory it visits
+        if (is_recursive_enabled == 1) {
+            list_directory_tree(directories[i], regular_file_count != 0 || i > 0);
+            continue;
+        }
 	// Print directory name if there are files or multiple arguments
         if (regular_file_count != 0 || argument_count > 1) {
-            printf("\n%s:\n", directories[i]);
-        }
-        if (is_long_format_enabled == 1) {
-            list_directory_long_format(directories[i]); // Long format display for directories
-        } else if (is_no_option_enabled == 1 || is_hidden_files_enabled == 1) {
-            do_ls(directories[i]); // Standard display for directories
+            out_puts(out_current, "\n");
+            out_puts(out_current, directories[i]);
+            out_puts(out_current, ":\n");
         }
+        emit_argument(&batch, regular_file_count + i);
     }
+    pool_wait(&group);
+    free(batch.outputs);
 }
 
-
 int main(int argc, char *argv[]) {
     uint8_t opt_flag = 0;                          // Flag to track options provided
     int opt;                                       // Variable to store the current option
@@ -86,13 +298,22 @@ int main(int argc, char *argv[]) {
 
     directory = getcwd(buffer, sizeof(buffer));   // Get current working directory
 
+    // Set locale for Arabic (or any desired locale) once, before any time is formatted
+    if (!setlocale(LC_TIME, "ar_AE.UTF-8")) {
+        setlocale(LC_TIME, "C"); // Default to English if Arabic locale is not available
+    }
+    tzset(); // Load the timezone once; localtime_r does not have to
+    output_line_width = terminal_line_width(); // Columns of the terminal (or COLUMNS, or 80)
+
     // If no arguments are provided
     if (argc == 1) {
         do_ls(directory);                          // List the contents of the current directory
     } else {
         // Process command-line options
-        while ((opt = getopt(argc, argv, "lautdcfi1")) != -1){ 
-            is_no_option_enabled = 1;              // Set flag indicating options have been processed
+        while ((opt = getopt_long(argc, argv, "lautdcfi1R", long_options, NULL)) != -1){ 
+            if (opt < OPT_DIRENT_BUFFER) {
+                is_no_option_enabled = 1;          // Set flag indicating listing options have been processed
+            }
             switch (opt) {
                 case 'l':
                     is_long_format_enabled = 1;    // Enable long format
@@ -121,12 +342,70 @@ int main(int argc, char *argv[]) {
                 case '1':
                     is_column_output_enabled = 1;   // Print in single-column format
                     break;
+                case 'R':
+                    is_recursive_enabled = 1;       // List subdirectories recursively
+                    break;
+                case OPT_DIRENT_BUFFER:
+                    if (parse_size(optarg, &dirent_buffer_size) == -1 || dirent_buffer_size < MIN_DIRENT_BUFFER_SIZE) {
+                        fprintf(stderr, "%s: invalid directory buffer size '%s'\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    break;
+                case OPT_NO_SYNC:
+                    is_dont_sync_enabled = 1;       // Do not force attribute revalidation on network filesystems
+                    break;
+                case OPT_NO_IO_URING:
+                    is_io_uring_enabled = 0;        // Always load metadata with synchronous statx calls
+                    break;
+                case OPT_THREADS:
+                    if (parse_size(optarg, &worker_thread_count) == -1 || worker_thread_count == 0) {
+                        fprintf(stderr, "%s: invalid thread count '%s'\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    break;
+                case OPT_COLLATE:
+                    is_collate_enabled = 1;         // Order names the way the user's locale collates them
+                    setlocale(LC_COLLATE, "");
+                    break;
+                case OPT_SORT_ENGINE:
+                    if (strcmp(optarg, "radix") == 0) {
+                        is_radix_sort_enabled = 1;
+                    } else if (strcmp(optarg, "qsort") == 0) {
+                        is_radix_sort_enabled = 0;
+                    } else {
+                        fprintf(stderr, "%s: invalid sort engine '%s' (expected radix or qsort)\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    break;
+                case OPT_PARALLEL_SORT_THRESHOLD:
+                    if (parse_size(optarg, &parallel_sort_threshold) == -1) {
+                        fprintf(stderr, "%s: invalid parallel sort threshold '%s'\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    break;
+                case OPT_TOP:
+                case OPT_BOTTOM:
+                    if (parse_size(optarg, &top_entry_count) == -1 || top_entry_count == 0) {
+                        fprintf(stderr, "%s: invalid entry count '%s'\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    is_bottom_enabled = opt == OPT_BOTTOM;  // Keep the oldest entries instead of the newest
+                    break;
+                case OPT_DEPTH_FIRST:
+                    is_depth_first_enabled = 1;     // Stream -R output with memory bounded by the tree depth
+                    break;
+                case OPT_FD_BUDGET:
+                    if (parse_size(optarg, &walk_fd_budget) == -1) {
+                        fprintf(stderr, "%s: invalid descriptor budget '%s'\n", argv[0], optarg);
+                        return EXIT_FAILURE;
+                    }
+                    break;
                 case '?':
                     // Handle invalid options
                     fprintf(stderr, "Usage: %s [-l [directory1 [directory2 ...]]]\n", argv[0]);
                     break;
                 default:
-                    printf("Unexpected case in switch()\n");
+                    out_puts(out_current, "Unexpected case in switch()\n");
                     break;
             }
         }
@@ -134,7 +413,7 @@ int main(int argc, char *argv[]) {
 
         // If no options are provided (opt_flag == 0)
         if (is_no_option_enabled == 0) {
-            uint8_t i = 1; // Start after program name
+            int i = optind; // Start after program name and any tuning options
             argCount = 0; // Reset argument count
             is_no_option_enabled = 1; // Set flag for options
             // Collect all arguments from argv
@@ -144,11 +423,12 @@ int main(int argc, char *argv[]) {
                 }
                 i++;
             }
-            sort_and_display(multiArgs, argCount);
+            if (argCount == 0 && argc > 1) {
+                do_ls(directory); // Only tuning options were given
+            } else {
+                sort_and_display(multiArgs, argCount);
+            }
         } else {
-		if(argCount == 0){
-                     dir = directory ;
-		}		     
             // Collect all arguments following the options
             while (optind < argc && argv[optind][0] != '-') {
                 if (argCount < MAX_ARGS) {
@@ -159,7 +439,13 @@ int main(int argc, char *argv[]) {
                 }
             }
             // Conditional logic based on flags and argument count
-            if (argCount == 0 && is_long_format_enabled == 1 && is_directory_option_enabled == 0) {
+            if (is_recursive_enabled == 1 && is_directory_option_enabled == 0) {
+                if (argCount == 0) {
+                    list_directory_tree(".", 0); // Recurse from the current directory
+                } else {
+                    sort_and_display(multiArgs, argCount);
+                }
+            } else if (argCount == 0 && is_long_format_enabled == 1 && is_directory_option_enabled == 0) {
                 list_directory_long_format(directory); // Use default directory
             } else if (argCount > 0 && is_long_format_enabled == 1 && is_directory_option_enabled == 0) {
                 // Sort and display the collected arguments (files and directories)
@@ -177,10 +463,10 @@ int main(int argc, char *argv[]) {
             } else if (argCount == 0 && is_directory_option_enabled == 1) {
                 // Handle the case where only the directory flag is set
                 if (is_no_sort_enabled == 1) {
-                    printf(".\n"); // Print current directory
+                    out_puts(out_current, ".\n"); // Print current directory
                 } else {
                     print_with_color("."); // Print current directory with color
-                    printf("\n");
+                    out_putc(out_current, '\n');
                 }
             } else if (argCount > 0 && is_directory_option_enabled == 1) {
                 list_directories(multiArgs, argCount); // List specified directories
@@ -188,6 +474,7 @@ int main(int argc, char *argv[]) {
         }
     
 
+    out_flush(&stdout_buf); // Write out whatever is still buffered
     return 0; // Exit program successfully
 }
 